@@ -50,7 +50,9 @@
 #include "ns3/node-container.h"
 #include "ns3/object-factory.h"
 #include "ns3/omnet-data-output.h"
+#ifdef SAF_HAVE_SQLITE
 #include "ns3/sqlite-data-output.h"
+#endif
 
 #include "ns3/mobility-module.h"
 #include "ns3/netanim-module.h"
@@ -61,10 +63,15 @@
 #include "ns3/yans-wifi-helper.h"
 
 #include "ns3/saf-helper.h"
+#include "ns3/saf-stats-sampler.h"
+#include "ns3/saf-stats-sink.h"
 #include "ns3/util.h"
 
 #include "nsutil.h"
 #include "simulation-params.h"
+#ifdef SAF_HAVE_SQLITE
+#include "sweep.h"
+#endif
 
 using namespace ns3;
 using namespace saf;
@@ -73,156 +80,44 @@ bool verbose = true;
 
 DataCollector data;
 
-Ptr<CounterCalculator<> > m_cache_hit;
+// every counter and delay of the applications, see SafStatsSink for what they count
+Ptr<SafCounterSink> m_stats;
 
-// these is only for the application level data lookups
-// this will exclude the lookups for reallocation purposes
-Ptr<CounterCalculator<> > m_lookup_sent;
-Ptr<CounterCalculator<> > m_lookup_rcv;
+// the wall clock nanoseconds spent on each overheard item
+Ptr<MinMaxAvgTotalCalculator<int64_t> > m_overheard_time;
 
-Ptr<CounterCalculator<> > m_lookup_rsp_sent;
-// lookup rsp receive will bt the lookup late + lookup ontime
+// number of bytes the application copies out of each received packet
+Ptr<MinMaxAvgTotalCalculator<uint32_t> > m_rx_bytes_copied;
 
-// these will count the number of times that the request timed out
-// of times late is high then the application timeout should be increased
-// if the timouts is higher then the late then it probably means that data is lost
-// or that no one has what your looking for and a longer timeout will not improve
-// things
-Ptr<CounterCalculator<> > m_lookup_timeout;
-Ptr<CounterCalculator<> > m_realloc_timeout;
+void overheard_time_CB(int64_t nanoseconds) { m_overheard_time->Update(nanoseconds); }
 
-// this will count the lookups for just the reallocation
-// lookups  not the application ones
-Ptr<CounterCalculator<> > m_realloc_sent;
-Ptr<CounterCalculator<> > m_realloc_rcv;
-
-Ptr<CounterCalculator<> > m_realloc_rsp_sent;
-// realoc rsp receive will bt the realoc late + realoc ontime
-
-// timings for application lookup responses
-Ptr<TimeMinMaxAvgTotalCalculator> m_lookup_ontime;
-Ptr<TimeMinMaxAvgTotalCalculator> m_lookup_late;
-
-// timings for realloc responses
-Ptr<TimeMinMaxAvgTotalCalculator> m_realloc_ontime;
-Ptr<TimeMinMaxAvgTotalCalculator> m_realloc_late;
-
-void cache_hit_CB(uint16_t dataID, uint32_t nodeID) { m_cache_hit->Update(); }
-
-void lookup_sent_CB(uint16_t dataID, uint32_t nodeID) { m_lookup_sent->Update(); }
-
-void lookup_rcv_CB(uint16_t dataID, uint32_t nodeID) { m_lookup_rcv->Update(); }
-
-void lookup_rsp_sent_CB(uint16_t dataID, uint32_t nodeID) { m_lookup_rsp_sent->Update(); }
-
-void lookup_timeout_CB(uint32_t requestID, uint32_t nodeID) { m_lookup_timeout->Update(); }
-
-void realloc_timeout_CB(uint32_t requestID, uint32_t nodeID) { m_realloc_timeout->Update(); }
-
-void realloc_sent_CB(uint16_t dataID, uint32_t nodeID) { m_realloc_sent->Update(); }
-
-void realloc_rcv_CB(uint16_t dataID, uint32_t nodeID) { m_realloc_rcv->Update(); }
-
-void realloc_rsp_sent_CB(uint16_t dataID, uint32_t nodeID) { m_realloc_rsp_sent->Update(); }
-
-void lookup_ontime_CB(uint16_t dataID, uint32_t nodeID, Time delay) {
-  m_lookup_ontime->Update(delay);
-}
-
-void lookup_late_CB(uint16_t dataID, uint32_t nodeID, Time delay) { m_lookup_late->Update(delay); }
-
-void realloc_ontime_CB(uint16_t dataID, uint32_t nodeID, Time delay) {
-  m_realloc_ontime->Update(delay);
-}
-
-void realloc_late_CB(uint16_t dataID, uint32_t nodeID, Time delay) {
-  m_realloc_late->Update(delay);
-}
+void rx_bytes_copied_CB(uint32_t bytes) { m_rx_bytes_copied->Update(bytes); }
 
 void setupStats(uint32_t runNum, std::string input) {
   // change some of this stuff to real values that are not hardcoded
   data.DescribeRun("SAF experiment", "wireless", input, std::to_string(runNum));
   data.AddMetadata("Author", "Marshall Asch");
 
-  m_cache_hit = CreateObject<CounterCalculator<> >();
-  m_lookup_sent = CreateObject<CounterCalculator<> >();
-  m_lookup_rcv = CreateObject<CounterCalculator<> >();
-  m_lookup_rsp_sent = CreateObject<CounterCalculator<> >();
-  m_lookup_timeout = CreateObject<CounterCalculator<> >();
-  m_realloc_timeout = CreateObject<CounterCalculator<> >();
-  m_realloc_sent = CreateObject<CounterCalculator<> >();
-  m_realloc_rcv = CreateObject<CounterCalculator<> >();
-  m_realloc_rsp_sent = CreateObject<CounterCalculator<> >();
-
-  m_lookup_ontime = CreateObject<TimeMinMaxAvgTotalCalculator>();
-  m_lookup_late = CreateObject<TimeMinMaxAvgTotalCalculator>();
-  m_realloc_ontime = CreateObject<TimeMinMaxAvgTotalCalculator>();
-  m_realloc_late = CreateObject<TimeMinMaxAvgTotalCalculator>();
-
-  m_cache_hit->SetKey("cache-hit");
-  m_lookup_sent->SetKey("lookup-sent");
-  m_lookup_rcv->SetKey("lookup-rcv");
-  m_lookup_rsp_sent->SetKey("lookup-rsp-sent");
-  m_lookup_timeout->SetKey("lookup-timeout");
-  m_realloc_timeout->SetKey("realloc-timeout");
-  m_realloc_sent->SetKey("realloc-sent");
-  m_realloc_rcv->SetKey("realloc-rcv");
-  m_realloc_rsp_sent->SetKey("realloc-rsp-sent");
-  m_lookup_ontime->SetKey("lookup-ontime-delay");
-  m_lookup_late->SetKey("lookup-late-delay");
-  m_realloc_ontime->SetKey("realloc-ontime-delay");
-  m_realloc_late->SetKey("realloc-late-delay");
-
-  data.AddDataCalculator(m_cache_hit);
-  data.AddDataCalculator(m_lookup_sent);
-  data.AddDataCalculator(m_lookup_rcv);
-  data.AddDataCalculator(m_lookup_rsp_sent);
-  data.AddDataCalculator(m_lookup_timeout);
-  data.AddDataCalculator(m_realloc_timeout);
-  data.AddDataCalculator(m_realloc_sent);
-  data.AddDataCalculator(m_realloc_rcv);
-  data.AddDataCalculator(m_realloc_rsp_sent);
-  data.AddDataCalculator(m_lookup_ontime);
-  data.AddDataCalculator(m_lookup_late);
-  data.AddDataCalculator(m_realloc_ontime);
-  data.AddDataCalculator(m_realloc_late);
+  m_stats = CreateObject<SafCounterSink>();
+  m_stats->AddCalculators(data);
+
+  m_overheard_time = CreateObject<MinMaxAvgTotalCalculator<int64_t> >();
+  m_rx_bytes_copied = CreateObject<MinMaxAvgTotalCalculator<uint32_t> >();
+
+  m_overheard_time->SetKey("overheard-time-ns");
+  m_rx_bytes_copied->SetKey("rx-bytes-copied");
+
+  data.AddDataCalculator(m_overheard_time);
+  data.AddDataCalculator(m_rx_bytes_copied);
 }
 
 /**
- * This is the main entry point to start the simulator.
- * Needs to set everything up so that it can run
+ * Run one simulation with the given parameters.
  *
+ * The results are written to a SQLite database with the given file prefix,
+ * or as OMNeT++ output files if it is empty or SQLite is not available.
  */
-int main(int argc, char* argv[]) {
-  // application parameters to be added
-  // num nodes
-  // num data items (must be less than 100 data items )
-  // memory space - C (10, 1-39)
-  // data item size
-  // data access rates for each item is known and constant
-  // relocation period - T (unused for SAF) (256, 1-8192)
-  // max node speed - d (1)
-  // communication range - R (7, 1-19)
-  // simulation time = 50000
-
-  SimulationParameters params;
-  bool ok;
-  std::tie(params, ok) = SimulationParameters::parse(argc, argv);
-
-  Time::SetResolution(Time::NS);
-
-  if (!ok) {
-    std::cerr << "Error parsing the parameters.\n";
-    return -1;
-  }
-
-  if (params.dryRun) {
-    std::cout << "dry run only printing the paramaters this is going to be run with\n";
-    std::cout << "==============================================================\n";
-    std::cout << std::string(params) << "\n";
-    return 0;
-  }
-
+int runSimulation(const SimulationParameters& params, const std::string& dbPrefix) {
   // this will set a seed so that the same numbers are not generated each time.
   // the run number should be incremented each time this simulation is run to ensure streams do not
   // overlap
@@ -328,19 +223,11 @@ int main(int argc, char* argv[]) {
   SafApplicationHelper app(5000, params.totalNodes, params.totalDataItems);
   // any extra paramters would be set here
 
-  app.SetAttribute("cache_hit_CB", CallbackValue(MakeCallback(&cache_hit_CB)));
-  app.SetAttribute("lookup_sent_CB", CallbackValue(MakeCallback(&lookup_sent_CB)));
-  app.SetAttribute("lookup_rcv_CB", CallbackValue(MakeCallback(&lookup_rcv_CB)));
-  app.SetAttribute("lookup_rsp_sent_CB", CallbackValue(MakeCallback(&lookup_rsp_sent_CB)));
-  app.SetAttribute("lookup_timeout_CB", CallbackValue(MakeCallback(&lookup_timeout_CB)));
-  app.SetAttribute("realloc_timeout_CB", CallbackValue(MakeCallback(&realloc_timeout_CB)));
-  app.SetAttribute("realloc_sent_CB", CallbackValue(MakeCallback(&realloc_sent_CB)));
-  app.SetAttribute("realloc_rcv_CB", CallbackValue(MakeCallback(&realloc_rcv_CB)));
-  app.SetAttribute("realloc_rsp_sent_CB", CallbackValue(MakeCallback(&realloc_rsp_sent_CB)));
-  app.SetAttribute("lookup_ontime_CB", CallbackValue(MakeCallback(&lookup_ontime_CB)));
-  app.SetAttribute("lookup_late_CB", CallbackValue(MakeCallback(&lookup_late_CB)));
-  app.SetAttribute("realloc_ontime_CB", CallbackValue(MakeCallback(&realloc_ontime_CB)));
-  app.SetAttribute("realloc_late_CB", CallbackValue(MakeCallback(&realloc_late_CB)));
+  m_stats->Reserve(params.totalNodes);
+  if (!params.itemMatrixFilePath.empty()) {
+    m_stats->EnableItemMatrix(params.totalDataItems);
+  }
+  app.SetAttribute("StatsSink", PointerValue(m_stats));
 
   app.SetAttribute("NumNodes", UintegerValue(params.totalNodes));
   app.SetAttribute("TotalDataItems", UintegerValue(params.totalDataItems));
@@ -350,8 +237,16 @@ int main(int argc, char* argv[]) {
   app.SetAttribute("accessFrequencyMode", UintegerValue(params.accessFrequencyType));
   app.SetAttribute("standardDeviation", DoubleValue(params.standardDeviation));
   app.SetAttribute("StorageSpace", UintegerValue(params.replicaSpace));
+  app.SetAttribute("NeighborRange", DoubleValue(params.wifiRadius));
 
   ApplicationContainer apps = app.Install(nodes);
+  app.AssignStreams(nodes, 0);  // fixed streams so runs only change with the run number
+  Config::ConnectWithoutContext(
+      "/NodeList/*/ApplicationList/*/$ns3::SafApplication/RxBytesCopied",
+      MakeCallback(&rx_bytes_copied_CB));
+  Config::ConnectWithoutContext(
+      "/NodeList/*/ApplicationList/*/$ns3::SafApplication/OverheardTime",
+      MakeCallback(&overheard_time_CB));
 
   // pick a start and end time that makes sense, maybe wait a little for the network to get setup
   // or something
@@ -368,11 +263,92 @@ int main(int argc, char* argv[]) {
   // wifiPhy.EnablePcapAll("saf", false);
 
   // actually run the simulation
+  Ptr<SafStatsSampler> sampler;
+  if (!params.sampleFilePath.empty()) {
+    sampler = CreateObject<SafStatsSampler>();
+    sampler->SetAttribute("Interval", TimeValue(params.relocationPeriod));
+    if (!sampler->Start(m_stats, params.sampleFilePath)) {
+      std::cerr << "Failed to open " << params.sampleFilePath << "\n";
+      return 1;
+    }
+  }
+
   Simulator::Stop(params.runtime);
   Simulator::Run();
+  if (sampler != 0) {
+    sampler->Stop();
+  }
+  m_stats->Flush();
+  if (!params.itemMatrixFilePath.empty()) {
+    const std::string& path = params.itemMatrixFilePath;
+    bool csv = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+    const ItemCounterMatrix& matrix = m_stats->GetItemMatrix();
+    if (!(csv ? matrix.WriteCsv(path) : matrix.WriteBinary(path))) {
+      std::cerr << "Failed to write the item matrix to " << path << "\n";
+    }
+  }
   Ptr<DataOutputInterface> output = CreateObject<OmnetDataOutput>();
+#ifdef SAF_HAVE_SQLITE
+  if (!dbPrefix.empty()) {
+    output = CreateObject<SqliteDataOutput>();
+    output->SetFilePrefix(dbPrefix);
+  }
+#endif
   output->Output(data);
   Simulator::Destroy();
 
   return 0;
 }
+
+/**
+ * This is the main entry point to start the simulator.
+ * Needs to set everything up so that it can run
+ *
+ */
+int main(int argc, char* argv[]) {
+  // application parameters to be added
+  // num nodes
+  // num data items (must be less than 100 data items )
+  // memory space - C (10, 1-39)
+  // data item size
+  // data access rates for each item is known and constant
+  // relocation period - T (unused for SAF) (256, 1-8192)
+  // max node speed - d (1)
+  // communication range - R (7, 1-19)
+  // simulation time = 50000
+
+  SimulationParameters params;
+  bool ok;
+  std::tie(params, ok) = SimulationParameters::parse(argc, argv);
+
+  Time::SetResolution(Time::NS);
+
+  if (!ok) {
+    std::cerr << "Error parsing the parameters.\n";
+    return -1;
+  }
+
+  // a sweep runs every combination of the swept parameters, each in its own process
+  std::vector<SimulationParameters> jobs(1, params);
+#ifdef SAF_HAVE_SQLITE
+  if (!params.sweepDatabasePath.empty()) {
+    jobs = expandSweep(params);
+  }
+#endif
+
+  if (params.dryRun) {
+    std::cout << "dry run only printing the paramaters this is going to be run with\n";
+    std::cout << "==============================================================\n";
+    for (const SimulationParameters& job : jobs) {
+      std::cout << std::string(job) << "\n";
+    }
+    return 0;
+  }
+
+#ifdef SAF_HAVE_SQLITE
+  if (!params.sweepDatabasePath.empty()) {
+    return runSweep(jobs, params.sweepWorkers, params.sweepDatabasePath, &runSimulation) ? 0 : 1;
+  }
+#endif
+  return runSimulation(params, "");
+}
@@ -16,6 +16,7 @@
 
 #include <inttypes.h>
 #include <cmath>
+#include <sstream>
 #include <utility>
 
 #include "ns3/nstime.h"
@@ -31,6 +32,23 @@
 namespace saf {
 using namespace ns3;
 
+// parse a comma separated list of values, an empty string is an empty list
+template <typename T>
+static bool parseList(const std::string& str, std::vector<T>& values) {
+  std::istringstream stream(str);
+  std::string field;
+  while (std::getline(stream, field, ',')) {
+    std::istringstream fieldStream(field);
+    T value;
+    if (!(fieldStream >> value) || !(fieldStream >> std::ws).eof()) {
+      std::cerr << "'" << field << "' in '" << str << "' is not a valid value" << std::endl;
+      return false;
+    }
+    values.push_back(value);
+  }
+  return true;
+}
+
 // static
 std::pair<SimulationParameters, bool> SimulationParameters::parse(int argc, char* argv[]) {
   /* Default simulation values. */
@@ -75,6 +93,21 @@ std::pair<SimulationParameters, bool> SimulationParameters::parse(int argc, char
   // Animation parameters.
   std::string animationTraceFilePath = "saf.xml";
 
+  // Per node and item counts, off unless a path is given.
+  std::string itemMatrixFilePath = "";
+
+  // Statistics of every relocation period, off unless a path is given.
+  std::string sampleFilePath = "";
+
+  // Parameter sweep, off unless a database is given.
+  std::string sweepDatabasePath = "";
+  std::string optSweepSeeds = "";
+  std::string optSweepNodes = "";
+  std::string optSweepReplicaSpace = "";
+  std::string optSweepRelocationPeriods = "";
+  uint32_t optSweepRuns = 1;
+  uint32_t optSweepWorkers = 0;
+
   bool optDryRun = false;
 
   /* Setup commandline option for each simulation parameter. */
@@ -128,6 +161,33 @@ std::pair<SimulationParameters, bool> SimulationParameters::parse(int argc, char
 
   cmd.AddValue("routing", "One of either 'DSDV' or 'AODV'", optRoutingProtocol);
   cmd.AddValue("animation-xml", "Output file path for NetAnim trace file", animationTraceFilePath);
+  cmd.AddValue(
+      "item-matrix",
+      "Output file path for the lookup counts of every node and item, CSV if it ends in .csv",
+      itemMatrixFilePath);
+  cmd.AddValue(
+      "sample-file",
+      "Output CSV file path for the statistics of every relocation period",
+      sampleFilePath);
+  cmd.AddValue(
+      "sweep-db",
+      "Run every combination of the sweep values and merge the results into this SQLite file",
+      sweepDatabasePath);
+  cmd.AddValue("sweep-seeds", "Comma separated simulation seeds to sweep", optSweepSeeds);
+  cmd.AddValue("sweep-nodes", "Comma separated numbers of nodes to sweep", optSweepNodes);
+  cmd.AddValue(
+      "sweep-space",
+      "Comma separated numbers of replicas each node can hold to sweep",
+      optSweepReplicaSpace);
+  cmd.AddValue(
+      "sweep-period",
+      "Comma separated replica allocation periods in seconds to sweep",
+      optSweepRelocationPeriods);
+  cmd.AddValue("sweep-runs", "Number of runs of every combination in a sweep", optSweepRuns);
+  cmd.AddValue(
+      "workers",
+      "Number of simulations a sweep runs at once, 0 for one per core",
+      optSweepWorkers);
   cmd.Parse(argc, argv);
 
   /* Parse the parameters. */
@@ -215,6 +275,52 @@ std::pair<SimulationParameters, bool> SimulationParameters::parse(int argc, char
     return std::pair<SimulationParameters, bool>(result, false);
   }
 
+  std::vector<double> sweepPeriods;
+  if (!parseList(optSweepSeeds, result.sweepSeeds) ||
+      !parseList(optSweepNodes, result.sweepNodes) ||
+      !parseList(optSweepReplicaSpace, result.sweepReplicaSpace) ||
+      !parseList(optSweepRelocationPeriods, sweepPeriods)) {
+    return std::pair<SimulationParameters, bool>(result, false);
+  }
+  for (uint32_t nodes : result.sweepNodes) {
+    if (nodes == 0 || optTotalDataItems % nodes != 0) {
+      std::cerr << "Number of data items (" << optTotalDataItems
+                << ") must be divisable by every swept number of nodes (" << nodes << ")"
+                << std::endl;
+      return std::pair<SimulationParameters, bool>(result, false);
+    }
+  }
+  for (uint16_t space : result.sweepReplicaSpace) {
+    if (space > 150) {
+      std::cerr << "Swept replica storage space (" << space << ") is not valid" << std::endl;
+      return std::pair<SimulationParameters, bool>(result, false);
+    }
+  }
+  for (double period : sweepPeriods) {
+    // SafApplication's ReallocationPeriod attribute does not accept less than a second
+    if (period < 1) {
+      std::cerr << "swept replica allocation period (" << period
+                << ") must be at least 1 second" << std::endl;
+      return std::pair<SimulationParameters, bool>(result, false);
+    }
+    result.sweepRelocationPeriods.push_back(Seconds(period));
+  }
+  if (optSweepRuns == 0) {
+    std::cerr << "Number of sweep runs cannot be 0" << std::endl;
+    return std::pair<SimulationParameters, bool>(result, false);
+  }
+#ifndef SAF_HAVE_SQLITE
+  if (!sweepDatabasePath.empty()) {
+    std::cerr << "A sweep merges its results with SQLite, which this build does not have"
+              << std::endl;
+    return std::pair<SimulationParameters, bool>(result, false);
+  }
+#endif
+
+  result.sweepDatabasePath = sweepDatabasePath;
+  result.sweepRuns = optSweepRuns;
+  result.sweepWorkers = optSweepWorkers;
+
   result.seed = optSeed;
   result.runNumber = optRunNum;
   result.runtime = Seconds(optRuntime);
@@ -266,6 +372,8 @@ std::pair<SimulationParameters, bool> SimulationParameters::parse(int argc, char
   result.routingProtocol = routingType;
   result.wifiRadius = optWifiRadius;
   result.netanimTraceFilePath = animationTraceFilePath;
+  result.itemMatrixFilePath = itemMatrixFilePath;
+  result.sampleFilePath = sampleFilePath;
 
   return std::pair<SimulationParameters, bool>(result, ok);
 }
@@ -20,6 +20,7 @@
 
 #include <inttypes.h>
 #include <utility>
+#include <vector>
 
 #include "ns3/nstime.h"
 #include "ns3/position-allocator.h"
@@ -67,6 +68,14 @@ class SimulationParameters {
   /// results of the simulation.
   std::string netanimTraceFilePath;
 
+  /// The path on disk to write the per node and item lookup counts to, as CSV
+  /// if it ends in .csv and binary otherwise. Empty to not keep them.
+  std::string itemMatrixFilePath;
+
+  /// The path on disk to append a row of the statistics to every relocation
+  /// period, as CSV. Empty to not sample them.
+  std::string sampleFilePath;
+
   uint16_t replicaSpace;
   uint32_t dataSize;
   uint16_t accessFrequencyType;
@@ -79,6 +88,23 @@ class SimulationParameters {
 
   bool dryRun;
 
+  /// The SQLite database to merge the results of a sweep into. Empty to run
+  /// a single simulation with the parameters above.
+  std::string sweepDatabasePath;
+
+  /// The values a sweep runs every combination of, an empty list only uses
+  /// the single value given for the parameter.
+  std::vector<uint32_t> sweepSeeds;
+  std::vector<uint32_t> sweepNodes;
+  std::vector<uint16_t> sweepReplicaSpace;
+  std::vector<ns3::Time> sweepRelocationPeriods;
+
+  /// The number of runs of every combination in a sweep.
+  uint32_t sweepRuns;
+
+  /// The number of simulations a sweep runs at once, 0 for one per core.
+  uint32_t sweepWorkers;
+
   SimulationParameters() {}
 
   /// \brief Parses command line options to set simulation parameters.
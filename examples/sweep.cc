@@ -0,0 +1,277 @@
+/// \file sweep.cc
+
+#include <stdio.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <iostream>
+#include <map>
+
+#include "sweep.h"
+
+namespace saf {
+
+// the number of finished simulations merged in one transaction
+static const uint32_t MERGE_BATCH = 16;
+
+// add the run number before the extension of a per run output file
+static std::string runFilePath(const std::string& path, uint32_t runNumber) {
+  std::string::size_type dot = path.rfind('.');
+  std::string::size_type slash = path.rfind('/');
+  if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+    dot = path.size();
+  }
+  return path.substr(0, dot) + "-run" + std::to_string(runNumber) + path.substr(dot);
+}
+
+// the prefix of the database a worker writes, SqliteDataOutput adds the .db
+static std::string runDatabasePrefix(const std::string& dbPath, uint32_t runNumber) {
+  std::string path = runFilePath(dbPath, runNumber);
+  if (path.size() > 3 && path.compare(path.size() - 3, 3, ".db") == 0) {
+    path.resize(path.size() - 3);
+  }
+  return path;
+}
+
+std::vector<SimulationParameters> expandSweep(const SimulationParameters& params) {
+  std::vector<uint32_t> seeds = params.sweepSeeds;
+  std::vector<uint32_t> nodes = params.sweepNodes;
+  std::vector<uint16_t> spaces = params.sweepReplicaSpace;
+  std::vector<ns3::Time> periods = params.sweepRelocationPeriods;
+  if (seeds.empty()) {
+    seeds.push_back(params.seed);
+  }
+  if (nodes.empty()) {
+    nodes.push_back(params.totalNodes);
+  }
+  if (spaces.empty()) {
+    spaces.push_back(params.replicaSpace);
+  }
+  if (periods.empty()) {
+    periods.push_back(params.relocationPeriod);
+  }
+
+  std::vector<SimulationParameters> jobs;
+  jobs.reserve(seeds.size() * nodes.size() * spaces.size() * periods.size() * params.sweepRuns);
+  for (uint32_t seed : seeds) {
+    for (uint32_t totalNodes : nodes) {
+      for (uint16_t space : spaces) {
+        for (ns3::Time period : periods) {
+          for (uint32_t run = 0; run < params.sweepRuns; run++) {
+            SimulationParameters job = params;
+            job.seed = seed;
+            job.runNumber = params.runNumber + jobs.size();
+            job.totalNodes = totalNodes;
+            job.replicaSpace = space;
+            job.relocationPeriod = period;
+            if (!job.itemMatrixFilePath.empty()) {
+              job.itemMatrixFilePath = runFilePath(job.itemMatrixFilePath, job.runNumber);
+            }
+            if (!job.sampleFilePath.empty()) {
+              job.sampleFilePath = runFilePath(job.sampleFilePath, job.runNumber);
+            }
+            jobs.push_back(job);
+          }
+        }
+      }
+    }
+  }
+  return jobs;
+}
+
+// merge the finished databases in one transaction and remove them, they are kept if it fails
+static bool mergeBatch(sqlite3* db, std::vector<std::string>& finished) {
+  bool ok = sqlite3_exec(db, "BEGIN TRANSACTION", NULL, NULL, NULL) == SQLITE_OK;
+  for (const std::string& path : finished) {
+    ok = ok && mergeDatabase(db, path);
+  }
+  ok = ok && sqlite3_exec(db, "COMMIT", NULL, NULL, NULL) == SQLITE_OK;
+
+  if (ok) {
+    for (const std::string& path : finished) {
+      remove(path.c_str());
+    }
+  } else {
+    std::cerr << "Failed to merge the results of " << finished.size()
+              << " runs, their databases are kept\n";
+    sqlite3_exec(db, "ROLLBACK", NULL, NULL, NULL);
+  }
+  finished.clear();
+  return ok;
+}
+
+bool runSweep(
+    const std::vector<SimulationParameters>& jobs,
+    uint32_t workers,
+    const std::string& dbPath,
+    SimulationRunner run) {
+  if (workers == 0) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    workers = cores > 0 ? cores : 1;
+  }
+
+  remove(dbPath.c_str());
+  sqlite3* db;
+  if (sqlite3_open(dbPath.c_str(), &db) != SQLITE_OK) {
+    std::cerr << "Failed to open " << dbPath << ": " << sqlite3_errmsg(db) << "\n";
+    sqlite3_close(db);
+    return false;
+  }
+
+  bool ok = true;
+  std::map<pid_t, size_t> running;  // worker -> job
+  std::vector<std::string> finished;
+  size_t next = 0;
+  while (next < jobs.size() || !running.empty()) {
+    while (next < jobs.size() && running.size() < workers) {
+      std::string prefix = runDatabasePrefix(dbPath, jobs[next].runNumber);
+
+      // anything still buffered would be written by the worker as well
+      std::cout.flush();
+      std::cerr.flush();
+      fflush(NULL);
+
+      pid_t pid = fork();
+      if (pid == 0) {
+        remove((prefix + ".db").c_str());
+        int status = run(jobs[next], prefix);
+        std::cout.flush();
+        std::cerr.flush();
+        _exit(status);
+      }
+      if (pid < 0) {
+        std::cerr << "Failed to start a worker for run " << jobs[next].runNumber << "\n";
+        ok = false;
+        break;
+      }
+      running[pid] = next++;
+    }
+    if (running.empty()) {
+      break;  // no worker could be started
+    }
+
+    int status;
+    pid_t pid = waitpid(-1, &status, 0);
+    if (pid < 0) {
+      std::cerr << "Failed to wait for the workers\n";
+      ok = false;
+      break;
+    }
+    std::map<pid_t, size_t>::iterator it = running.find(pid);
+    if (it == running.end()) {
+      continue;
+    }
+    const SimulationParameters& job = jobs[it->second];
+    running.erase(it);
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      std::cerr << "Run " << job.runNumber << " failed: " << std::string(job) << "\n";
+      ok = false;
+      continue;
+    }
+    std::cout << "Finished run " << job.runNumber << " (" << jobs.size() - next + running.size()
+              << " left)\n";
+
+    finished.push_back(runDatabasePrefix(dbPath, job.runNumber) + ".db");
+    if (finished.size() >= MERGE_BATCH) {
+      ok = mergeBatch(db, finished) && ok;
+    }
+  }
+
+  // wait for any workers left after an error so none of them outlive the sweep
+  while (!running.empty()) {
+    int status;
+    pid_t pid = waitpid(-1, &status, 0);
+    if (pid < 0) {
+      break;
+    }
+    running.erase(pid);
+  }
+
+  if (!finished.empty()) {
+    ok = mergeBatch(db, finished) && ok;
+  }
+  sqlite3_close(db);
+  return ok;
+}
+
+// copy every row of the table, creating it first if it is missing
+static bool mergeTable(
+    sqlite3* into,
+    sqlite3* from,
+    const std::string& table,
+    const std::string& schema) {
+  // the stored schema never has IF NOT EXISTS
+  std::string create = schema;
+  const std::string createTable = "CREATE TABLE ";
+  if (create.compare(0, createTable.size(), createTable) == 0) {
+    create.insert(createTable.size(), "IF NOT EXISTS ");
+  }
+  if (sqlite3_exec(into, create.c_str(), NULL, NULL, NULL) != SQLITE_OK) {
+    return false;
+  }
+
+  std::string quoted = "\"" + table + "\"";
+  sqlite3_stmt* select;
+  if (sqlite3_prepare_v2(from, ("SELECT * FROM " + quoted).c_str(), -1, &select, NULL) !=
+      SQLITE_OK) {
+    return false;
+  }
+
+  int columns = sqlite3_column_count(select);
+  std::string insert = "INSERT INTO " + quoted + " VALUES (";
+  for (int i = 0; i < columns; i++) {
+    insert += i == 0 ? "?" : ", ?";
+  }
+  insert += ")";
+
+  sqlite3_stmt* stmt;
+  if (sqlite3_prepare_v2(into, insert.c_str(), -1, &stmt, NULL) != SQLITE_OK) {
+    sqlite3_finalize(select);
+    return false;
+  }
+
+  bool ok = true;
+  int rc;
+  while (ok && (rc = sqlite3_step(select)) == SQLITE_ROW) {
+    for (int i = 0; i < columns; i++) {
+      sqlite3_bind_value(stmt, i + 1, sqlite3_column_value(select, i));
+    }
+    ok = sqlite3_step(stmt) == SQLITE_DONE;
+    sqlite3_reset(stmt);
+  }
+  ok = ok && rc == SQLITE_DONE;
+
+  sqlite3_finalize(stmt);
+  sqlite3_finalize(select);
+  return ok;
+}
+
+bool mergeDatabase(sqlite3* into, const std::string& from) {
+  sqlite3* source;
+  if (sqlite3_open_v2(from.c_str(), &source, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK) {
+    std::cerr << "Failed to open " << from << ": " << sqlite3_errmsg(source) << "\n";
+    sqlite3_close(source);
+    return false;
+  }
+
+  sqlite3_stmt* tables;
+  const char* query = "SELECT name, sql FROM sqlite_master WHERE type = 'table'";
+  bool ok = sqlite3_prepare_v2(source, query, -1, &tables, NULL) == SQLITE_OK;
+  int rc = SQLITE_DONE;
+  while (ok && (rc = sqlite3_step(tables)) == SQLITE_ROW) {
+    std::string table = (const char*)sqlite3_column_text(tables, 0);
+    std::string schema = (const char*)sqlite3_column_text(tables, 1);
+    ok = mergeTable(into, source, table, schema);
+  }
+  ok = ok && rc == SQLITE_DONE;
+
+  if (!ok) {
+    std::cerr << "Failed to merge " << from << ": " << sqlite3_errmsg(into) << "\n";
+  }
+  sqlite3_finalize(tables);
+  sqlite3_close(source);
+  return ok;
+}
+
+};  // namespace saf
@@ -0,0 +1,67 @@
+/// \file sweep.h
+/// \brief Runs a grid of simulations in a pool of worker processes and
+///     merges their results into one SQLite database.
+
+#ifndef __sweep_h
+#define __sweep_h
+
+#include <sqlite3.h>
+#include <string>
+#include <vector>
+
+#include "simulation-params.h"
+
+namespace saf {
+
+/// \brief Runs a single simulation and writes its results.
+///
+/// \param params The parameters of the simulation.
+/// \param dbPrefix The file prefix of the SQLite database to write the
+///   results to, empty to use the default output.
+/// \return int The exit status of the simulation, 0 on success.
+typedef int (*SimulationRunner)(const SimulationParameters& params, const std::string& dbPrefix);
+
+/// \brief Expands the sweep lists of the parameters into one set of
+///     parameters per simulation.
+///
+/// Every combination of seed, number of nodes, replica space and allocation
+/// period is repeated sweepRuns times, in that nesting order. Simulation i
+/// gets run number params.runNumber + i, so the random streams of a
+/// simulation only depend on the grid and never on the order the workers
+/// finish in. Any per run output files get the run number added to their
+/// name.
+///
+/// \param params The parsed parameters, with the sweep lists.
+/// \return std::vector<SimulationParameters> The parameters of every simulation.
+std::vector<SimulationParameters> expandSweep(const SimulationParameters& params);
+
+/// \brief Runs the simulations in forked worker processes and merges their
+///     results into one database.
+///
+/// Each worker writes its own database next to dbPath, finished databases
+/// are merged in batches with one transaction per batch and then removed.
+///
+/// \param jobs The parameters of every simulation.
+/// \param workers The number of simulations to run at once, 0 for one per core.
+/// \param dbPath The SQLite database to merge into, it is replaced if it exists.
+/// \param run Runs one simulation in a worker.
+/// \return bool false if any simulation failed or its results could not be merged.
+bool runSweep(
+    const std::vector<SimulationParameters>& jobs,
+    uint32_t workers,
+    const std::string& dbPath,
+    SimulationRunner run);
+
+/// \brief Copies every table of a database into another one.
+///
+/// Tables missing from the destination are created with the schema of the
+/// source. Runs inside whatever transaction is open on the destination.
+///
+/// \param into The database to copy the rows into.
+/// \param from The path of the database to copy from.
+/// \return bool false if the source could not be read or a row not be inserted.
+bool mergeDatabase(sqlite3* into, const std::string& from);
+
+};  // namespace saf
+
+#endif
@@ -1,6 +1,10 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 
+#include "ns3/double.h"
+#include "ns3/enum.h"
 #include "ns3/names.h"
+#include "ns3/nstime.h"
+#include "ns3/pointer.h"
 #include "ns3/uinteger.h"
 
 #include "saf-helper.h"
@@ -18,6 +22,7 @@ SafApplicationHelper::SafApplicationHelper(
       numDataitems != 0 && numNodes != 0,
       "Data items and number of nodes can not be zero");
 
+  m_next_index = 0;
   m_factory.SetTypeId(SafApplication::GetTypeId());
   SetAttribute("Port", UintegerValue(port));
   SetAttribute("NumNodes", UintegerValue(numNodes));
@@ -46,10 +51,78 @@ ApplicationContainer SafApplicationHelper::Install(NodeContainer c) const {
   return apps;
 }
 
+int64_t SafApplicationHelper::AssignStreams(NodeContainer c, int64_t stream) {
+  int64_t currentStream = stream;
+  for (NodeContainer::Iterator i = c.Begin(); i != c.End(); ++i) {
+    Ptr<Node> node = *i;
+    for (uint32_t j = 0; j < node->GetNApplications(); j++) {
+      Ptr<SafApplication> app = DynamicCast<SafApplication>(node->GetApplication(j));
+      if (app != 0) {
+        currentStream += app->AssignStreams(currentStream);
+      }
+    }
+  }
+  return currentStream - stream;
+}
+
 Ptr<Application> SafApplicationHelper::InstallPriv(Ptr<Node> node) const {
   Ptr<Application> app = m_factory.Create<SafApplication>();
+  app->SetAttribute("NodeIndex", UintegerValue(m_next_index++));
+
+  Ptr<SafCatalog> catalog = GetCatalog(app);
+  if (catalog != 0) {
+    app->SetAttribute("Catalog", PointerValue(catalog));
+  }
+
+  Ptr<ReplicaAllocationPolicy> policy = GetAllocationPolicy(app);
+  if (policy != 0) {
+    app->SetAttribute("ReplicaAllocationPolicy", PointerValue(policy));
+  }
+
   node->AddApplication(app);
 
   return app;
 }
+
+Ptr<SafCatalog> SafApplicationHelper::GetCatalog(Ptr<Application> app) const {
+  UintegerValue totalItems;
+  UintegerValue mode;
+  DoubleValue standardDeviation;
+  TimeValue period;
+  app->GetAttribute("TotalDataItems", totalItems);
+  app->GetAttribute("accessFrequencyMode", mode);
+  app->GetAttribute("standardDeviation", standardDeviation);
+  app->GetAttribute("ReallocationPeriod", period);
+
+  if (!SafCatalog::IsShareable(mode.Get())) {
+    return 0;
+  }
+
+  if (m_catalog == 0 ||
+      !m_catalog->Matches(totalItems.Get(), mode.Get(), standardDeviation.Get(), period.Get())) {
+    m_catalog = CreateObject<SafCatalog>();
+    m_catalog->Init(totalItems.Get(), mode.Get(), standardDeviation.Get(), period.Get());
+  }
+  return m_catalog;
+}
+
+Ptr<ReplicaAllocationPolicy> SafApplicationHelper::GetAllocationPolicy(Ptr<Application> app) const {
+  EnumValue scheme;
+  DoubleValue range;
+  app->GetAttribute("ReplicaAllocation", scheme);
+  app->GetAttribute("NeighborRange", range);
+
+  // SAF only looks at the node itself, so there is nothing to share
+  if (scheme.Get() == ReplicaAllocationPolicy::SAF) {
+    return 0;
+  }
+
+  if (m_allocation_policy == 0 || m_allocation_policy->GetScheme() != scheme.Get() ||
+      m_allocation_policy->GetRange() != range.Get()) {
+    m_allocation_policy =
+        ReplicaAllocationPolicy::Create(ReplicaAllocationPolicy::Scheme(scheme.Get()));
+    m_allocation_policy->SetAttribute("Range", range);
+  }
+  return m_allocation_policy;
+}
 }  // namespace ns3
@@ -7,6 +7,8 @@
 #include "ns3/node-container.h"
 #include "ns3/object-factory.h"
 
+#include "ns3/replica-allocation-policy.h"
+#include "ns3/saf-catalog.h"
 #include "ns3/saf.h"
 
 namespace ns3 {
@@ -64,9 +66,22 @@ class SafApplicationHelper {
    *
    * \returns The applications created, one Application per Node in the
    *          NodeContainer.
+   *
+   * Every node gets the next NodeIndex, in the order the nodes are
+   * installed, which picks its data and message IDs.
    */
   ApplicationContainer Install(NodeContainer c) const;
 
+  /**
+   * Assign fixed random variable stream numbers to the random variables used
+   * by the SAF applications installed on the nodes.
+   *
+   * \param c The nodes whose SAF applications should be modified.
+   * \param stream The first stream index to use.
+   * \returns The number of stream indices assigned.
+   */
+  int64_t AssignStreams(NodeContainer c, int64_t stream);
+
  private:
   /**
    * Install an ns3::UdpEchoServer on the node configured with all the
@@ -77,7 +92,30 @@ class SafApplicationHelper {
    */
   Ptr<Application> InstallPriv(Ptr<Node> node) const;
 
+  /**
+   * Get the catalog to share with an application, building it the first time
+   * it is needed or when the application was configured differently.
+   *
+   * \param app The application the catalog is for.
+   * \returns The shared catalog, or 0 if the application has to build its own.
+   */
+  Ptr<SafCatalog> GetCatalog(Ptr<Application> app) const;
+
+  /**
+   * Get the replica allocation policy to share with an application, building
+   * it the first time it is needed or when the application was configured
+   * differently.
+   *
+   * \param app The application the policy is for.
+   * \returns The shared policy, or 0 if the application has to build its own.
+   */
+  Ptr<ReplicaAllocationPolicy> GetAllocationPolicy(Ptr<Application> app) const;
+
   ObjectFactory m_factory;  //!< Object factory.
+
+  mutable Ptr<SafCatalog> m_catalog;  //!< Shared by every application that is installed.
+  mutable Ptr<ReplicaAllocationPolicy> m_allocation_policy;  //!< Shared like the catalog.
+  mutable uint32_t m_next_index;  //!< The NodeIndex of the next node that is installed.
 };
 
 }  // namespace ns3
@@ -0,0 +1,69 @@
+
+#include "ns3/assert.h"
+
+#include "data-id-set.h"
+
+namespace ns3 {
+
+DataIdSet::DataIdSet() {}
+
+DataIdSet::~DataIdSet() {}
+
+void DataIdSet::Init(uint16_t totalItems) {
+  m_index.assign(totalItems + 1, 0);  // data IDs start at 1
+  m_members.clear();
+  m_members.reserve(totalItems);
+}
+
+bool DataIdSet::Contains(uint16_t dataID) const {
+  return dataID < m_index.size() && m_index[dataID] != 0;
+}
+
+bool DataIdSet::Insert(uint16_t dataID) {
+  NS_ASSERT_MSG(dataID != 0 && dataID < m_index.size(), "data ID is outside of the set");
+
+  if (Contains(dataID)) {
+    return false;
+  }
+
+  m_members.push_back(dataID);
+  m_index[dataID] = m_members.size();
+  return true;
+}
+
+bool DataIdSet::Erase(uint16_t dataID) {
+  if (!Contains(dataID)) {
+    return false;
+  }
+
+  // move the last member into the freed slot so the array stays compact
+  uint16_t slot = m_index[dataID] - 1;
+  if (slot != m_members.size() - 1) {
+    m_members[slot] = m_members.back();
+    m_index[m_members[slot]] = slot + 1;
+  }
+  m_members.pop_back();
+  m_index[dataID] = 0;
+  return true;
+}
+
+void DataIdSet::Clear() {
+  for (std::vector<uint16_t>::const_iterator it = m_members.begin(); it != m_members.end();
+       ++it) {
+    m_index[*it] = 0;
+  }
+  m_members.clear();
+}
+
+void DataIdSet::Swap(DataIdSet& other) {
+  m_index.swap(other.m_index);
+  m_members.swap(other.m_members);
+}
+
+uint16_t DataIdSet::GetSize() const { return m_members.size(); }
+
+bool DataIdSet::IsEmpty() const { return m_members.empty(); }
+
+const std::vector<uint16_t>& DataIdSet::GetMembers() const { return m_members; }
+
+}  // namespace ns3
@@ -0,0 +1,50 @@
+#ifndef SAF_DATA_ID_SET_H
+#define SAF_DATA_ID_SET_H
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief A set of data IDs with O(1) insert, erase and membership.
+ *
+ * Like DataStore this keeps an ID indexed slot table next to a compact array
+ * of the members, so the members can be walked without looking at every
+ * possible data ID.
+ */
+class DataIdSet {
+ public:
+  DataIdSet();
+  ~DataIdSet();
+
+  // size the set for data IDs 1 to totalItems, any members are dropped
+  void Init(uint16_t totalItems);
+
+  bool Contains(uint16_t dataID) const;
+
+  // returns false if the ID is already a member
+  bool Insert(uint16_t dataID);
+
+  // returns false if the ID was not a member
+  bool Erase(uint16_t dataID);
+
+  void Clear();
+
+  // exchange the members of the two sets without copying them
+  void Swap(DataIdSet& other);
+
+  uint16_t GetSize() const;
+  bool IsEmpty() const;
+
+  // the members in no particular order
+  const std::vector<uint16_t>& GetMembers() const;
+
+ private:
+  std::vector<uint16_t> m_index;    // data ID -> slot + 1, 0 when the ID is not a member
+  std::vector<uint16_t> m_members;  // compact array of the members
+};
+
+}  // namespace ns3
+
+#endif /* SAF_DATA_ID_SET_H */
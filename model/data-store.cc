@@ -0,0 +1,81 @@
+
+#include "ns3/assert.h"
+
+#include "data-store.h"
+
+namespace ns3 {
+
+DataStore::DataStore() { m_capacity = 0; }
+
+DataStore::~DataStore() { m_capacity = 0; }
+
+void DataStore::Init(uint16_t totalItems, uint16_t capacity) {
+  m_index.assign(totalItems + 1, 0);  // data IDs start at 1
+  m_slots.clear();
+  m_slots.reserve(capacity);
+  m_capacity = capacity;
+}
+
+bool DataStore::Contains(uint16_t dataID) const {
+  return dataID < m_index.size() && m_index[dataID] != 0;
+}
+
+DataStatus DataStore::GetStatus(uint16_t dataID) const {
+  const Data* item = Find(dataID);
+  return item == 0 ? DataStatus::unknown : item->GetStatus();
+}
+
+const Data* DataStore::Find(uint16_t dataID) const {
+  if (!Contains(dataID)) {
+    return 0;
+  }
+  return &m_slots[m_index[dataID] - 1];
+}
+
+bool DataStore::Add(const Data& data) {
+  uint16_t dataID = data.GetDataID();
+  NS_ASSERT_MSG(dataID != 0 && dataID < m_index.size(), "data ID is outside of the store");
+
+  if (IsFull() || Contains(dataID)) {
+    return false;
+  }
+
+  m_slots.push_back(data);
+  m_index[dataID] = m_slots.size();
+  return true;
+}
+
+bool DataStore::Remove(uint16_t dataID) {
+  if (!Contains(dataID)) {
+    return false;
+  }
+
+  // move the last item into the freed slot so the array stays compact
+  uint16_t slot = m_index[dataID] - 1;
+  if (slot != m_slots.size() - 1) {
+    m_slots[slot] = m_slots.back();
+    m_index[m_slots[slot].GetDataID()] = slot + 1;
+  }
+  m_slots.pop_back();
+  m_index[dataID] = 0;
+  return true;
+}
+
+void DataStore::Clear() {
+  for (Iterator it = m_slots.begin(); it != m_slots.end(); ++it) {
+    m_index[it->GetDataID()] = 0;
+  }
+  m_slots.clear();
+}
+
+uint16_t DataStore::GetSize() const { return m_slots.size(); }
+
+uint16_t DataStore::GetCapacity() const { return m_capacity; }
+
+bool DataStore::IsFull() const { return m_slots.size() >= m_capacity; }
+
+DataStore::Iterator DataStore::Begin() const { return m_slots.begin(); }
+
+DataStore::Iterator DataStore::End() const { return m_slots.end(); }
+
+}  // namespace ns3
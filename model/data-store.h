@@ -0,0 +1,63 @@
+#ifndef SAF_DATA_STORE_H
+#define SAF_DATA_STORE_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "data.h"
+
+namespace ns3 {
+
+/**
+ * \brief Fixed capacity storage for the data items held by a node.
+ *
+ * Data IDs are dense and bounded by the total number of data items in the
+ * simulation, so membership is answered with an ID indexed slot table instead
+ * of scanning the stored items. The items themselves are kept in a compact
+ * array so iterating over them only touches what is actually stored.
+ */
+class DataStore {
+ public:
+  typedef std::vector<Data>::const_iterator Iterator;
+
+  DataStore();
+  ~DataStore();
+
+  /**
+   * Size the store for data IDs 1 to totalItems, holding at most capacity of them.
+   * Any items that were already stored are dropped.
+   */
+  void Init(uint16_t totalItems, uint16_t capacity);
+
+  bool Contains(uint16_t dataID) const;
+
+  // DataStatus::unknown when the item is not held by this store
+  DataStatus GetStatus(uint16_t dataID) const;
+
+  // returns 0 if the item is not held by this store
+  const Data* Find(uint16_t dataID) const;
+
+  // returns false if the store is full or the item is already held
+  bool Add(const Data& data);
+
+  // returns false if the item was not held by this store
+  bool Remove(uint16_t dataID);
+
+  void Clear();
+
+  uint16_t GetSize() const;
+  uint16_t GetCapacity() const;
+  bool IsFull() const;
+
+  Iterator Begin() const;
+  Iterator End() const;
+
+ private:
+  std::vector<uint16_t> m_index;  // data ID -> slot + 1, 0 when the item is not stored
+  std::vector<Data> m_slots;      // compact array of the stored items
+  uint16_t m_capacity;
+};
+
+}  // namespace ns3
+
+#endif /* SAF_DATA_STORE_H */
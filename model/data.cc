@@ -13,23 +13,13 @@ Data::Data() {
   m_type = DataType::unkown;
 }
 
-// when generating a new data item
-Data::Data(uint32_t size) {
-  static uint16_t id = 1;
-  m_data_id = id++;
-  m_pending_id = 0;
-  m_size = size;
-  m_status = DataStatus::stored;
-  m_type = DataType::origianal;
-}
-
-// when saving a data item
-Data::Data(uint16_t data_id, uint32_t size) {
+// when saving a data item, or generating one with a known ID
+Data::Data(uint16_t data_id, uint32_t size, DataType type) {
   m_data_id = data_id;
   m_pending_id = 0;
   m_size = size;
   m_status = DataStatus::stored;
-  m_type = DataType::replica;
+  m_type = type;
 }
 
 Data::~Data() {
@@ -42,12 +32,12 @@ Data::~Data() {
 
 void Data::SetStatus(DataStatus status) { m_status = status; }
 
-uint16_t Data::GetDataID() { return m_data_id; }
+uint16_t Data::GetDataID() const { return m_data_id; }
 
-uint16_t Data::GetPendingID() { return m_pending_id; }
+uint16_t Data::GetPendingID() const { return m_pending_id; }
 
-uint32_t Data::GetSize() { return m_size; }
+uint32_t Data::GetSize() const { return m_size; }
 
-DataStatus Data::GetStatus() { return m_status; }
+DataStatus Data::GetStatus() const { return m_status; }
 
 }  // Namespace ns3
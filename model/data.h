@@ -25,18 +25,18 @@ class Data {
   // per reloaction period
 
  public:
-  Data();                                 // default do not call this
-  Data(uint32_t size);                    // use this constructer when creating data items
-  Data(uint16_t data_id, uint32_t size);  // when saving a replica
+  Data();  // default do not call this
+  // when saving a replica, or creating an original with the ID of its node
+  Data(uint16_t data_id, uint32_t size, DataType type = DataType::replica);
   ~Data();
   // void AccessData();
   // void ResetAccessFrequency();
   void SetStatus(DataStatus status);
-  uint16_t GetDataID();
-  uint16_t GetPendingID();
-  uint32_t GetSize();
+  uint16_t GetDataID() const;
+  uint16_t GetPendingID() const;
+  uint32_t GetSize() const;
   // uint16_t GetAccessFrequency();
-  DataStatus GetStatus();
+  DataStatus GetStatus() const;
 };
 
 }  // namespace ns3
@@ -0,0 +1,86 @@
+
+#include <algorithm>
+
+#include "ns3/simulator.h"
+
+#include "deadline-queue.h"
+
+namespace ns3 {
+
+DeadlineQueue::DeadlineQueue() {
+  m_resolution = Seconds(0);
+  m_pushed = 0;
+}
+
+DeadlineQueue::~DeadlineQueue() { Clear(); }
+
+void DeadlineQueue::SetExpireCallback(Callback<void, uint32_t, uint8_t> expire) {
+  m_expire = expire;
+}
+
+void DeadlineQueue::SetResolution(Time resolution) { m_resolution = resolution; }
+
+void DeadlineQueue::Push(Time delay, uint32_t id, uint8_t kind) {
+  Time deadline = Simulator::Now() + delay;
+
+  if (m_resolution.IsStrictlyPositive()) {
+    int64_t step = m_resolution.GetTimeStep();
+    deadline = TimeStep(((deadline.GetTimeStep() + step - 1) / step) * step);
+  }
+
+  Entry entry;
+  entry.deadline = deadline;
+  entry.id = id;
+  entry.kind = kind;
+  entry.order = m_pushed++;
+  m_entries.push_back(entry);
+  std::push_heap(m_entries.begin(), m_entries.end(), Later);
+
+  // a shorter timeout can come due before the one the event is armed for
+  if (!m_event.IsRunning() || m_entries.front().order == entry.order) {
+    Simulator::Cancel(m_event);
+    Arm();
+  }
+}
+
+void DeadlineQueue::Clear() {
+  Simulator::Cancel(m_event);
+  m_entries.clear();
+}
+
+uint32_t DeadlineQueue::GetSize() const { return m_entries.size(); }
+
+bool DeadlineQueue::Later(const Entry& a, const Entry& b) {
+  if (a.deadline != b.deadline) {
+    return a.deadline > b.deadline;
+  }
+  return a.order > b.order;
+}
+
+void DeadlineQueue::Arm() {
+  m_event = Simulator::Schedule(
+      m_entries.front().deadline - Simulator::Now(),
+      &DeadlineQueue::Expire,
+      this);
+}
+
+void DeadlineQueue::Expire() {
+  Time now = Simulator::Now();
+
+  while (!m_entries.empty() && m_entries.front().deadline <= now) {
+    std::pop_heap(m_entries.begin(), m_entries.end(), Later);
+    Entry entry = m_entries.back();
+    m_entries.pop_back();
+
+    if (!m_expire.IsNull()) {
+      m_expire(entry.id, entry.kind);
+    }
+  }
+
+  // the callback may have pushed a new entry and armed the event already
+  if (!m_entries.empty() && !m_event.IsRunning()) {
+    Arm();
+  }
+}
+
+}  // namespace ns3
@@ -0,0 +1,70 @@
+#ifndef SAF_DEADLINE_QUEUE_H
+#define SAF_DEADLINE_QUEUE_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "ns3/callback.h"
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+/**
+ * \brief Request timeouts driven by a single scheduled event.
+ *
+ * Requests wait for different timeouts, an expanding ring search gives every
+ * ring its own, so the entries are kept in a min-heap on the deadline. Entries
+ * with the same deadline expire in the order they were pushed. Only the event
+ * for the earliest deadline is ever scheduled, and when it fires every entry
+ * that is due is expired in one batch. Deadlines can be rounded up to a
+ * resolution so that requests sent close together expire together.
+ *
+ * Entries are never removed before their deadline. Cancelling a timeout is
+ * done by the owner forgetting the request, so the expire callback has to
+ * ignore IDs that are no longer pending.
+ */
+class DeadlineQueue {
+ public:
+  DeadlineQueue();
+  ~DeadlineQueue();
+
+  // called with the ID and kind of every entry when its deadline passes
+  void SetExpireCallback(Callback<void, uint32_t, uint8_t> expire);
+
+  // deadlines are rounded up to a multiple of resolution, zero keeps them exact
+  void SetResolution(Time resolution);
+
+  // expire id after delay
+  void Push(Time delay, uint32_t id, uint8_t kind);
+
+  // drop every entry without expiring them
+  void Clear();
+
+  uint32_t GetSize() const;
+
+ private:
+  struct Entry {
+    Time deadline;
+    uint32_t id;
+    uint8_t kind;
+    uint64_t order;  // breaks ties between equal deadlines
+  };
+
+  // orders the heap so that the earliest entry is at the front
+  static bool Later(const Entry& a, const Entry& b);
+
+  void Arm();
+
+  void Expire();
+
+  std::vector<Entry> m_entries;  // a heap ordered by Later
+  EventId m_event;               // scheduled for the deadline of the first entry
+  uint64_t m_pushed;             // the order of the next entry
+  Time m_resolution;
+  Callback<void, uint32_t, uint8_t> m_expire;
+};
+
+}  // namespace ns3
+
+#endif /* SAF_DEADLINE_QUEUE_H */
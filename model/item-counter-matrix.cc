@@ -0,0 +1,136 @@
+
+#include <fstream>
+
+#include "ns3/assert.h"
+
+#include "item-counter-matrix.h"
+
+namespace ns3 {
+
+static const uint32_t BINARY_VERSION = 1;
+
+// the counter stops here instead of wrapping back to 0
+static const uint16_t SATURATED = 0xffff;
+
+static const char* const KIND_NAMES[ItemCounterMatrix::NUM_KINDS] = {
+    "hit",
+    "miss",
+    "timeout",
+    "late"};
+
+namespace {
+
+void WriteU32(std::ofstream& out, uint32_t value) {
+  char bytes[4] = {
+      (char)(value & 0xff),
+      (char)((value >> 8) & 0xff),
+      (char)((value >> 16) & 0xff),
+      (char)((value >> 24) & 0xff)};
+  out.write(bytes, sizeof(bytes));
+}
+
+}  // namespace
+
+ItemCounterMatrix::ItemCounterMatrix() {
+  m_nodes = 0;
+  m_items = 0;
+}
+
+ItemCounterMatrix::~ItemCounterMatrix() {}
+
+void ItemCounterMatrix::Init(uint32_t numNodes, uint16_t totalItems) {
+  m_nodes = numNodes;
+  m_items = totalItems;
+  m_counts.assign(numNodes * totalItems * NUM_KINDS, 0);
+}
+
+uint32_t ItemCounterMatrix::Index(uint32_t nodeID, uint16_t dataID, Kind kind) const {
+  return (nodeID * m_items + (dataID - 1)) * NUM_KINDS + kind;
+}
+
+void ItemCounterMatrix::Increment(uint32_t nodeID, uint16_t dataID, Kind kind) {
+  NS_ASSERT_MSG(dataID != 0 && dataID <= m_items, "data ID is outside of the matrix");
+
+  // the nodes are the outermost dimension, so growing only appends
+  if (nodeID >= m_nodes) {
+    m_nodes = nodeID + 1;
+    m_counts.resize(m_nodes * m_items * NUM_KINDS, 0);
+  }
+
+  uint16_t& count = m_counts[Index(nodeID, dataID, kind)];
+  if (count != SATURATED) {
+    count++;
+  }
+}
+
+uint16_t ItemCounterMatrix::Get(uint32_t nodeID, uint16_t dataID, Kind kind) const {
+  if (nodeID >= m_nodes || dataID == 0 || dataID > m_items) {
+    return 0;
+  }
+  return m_counts[Index(nodeID, dataID, kind)];
+}
+
+uint32_t ItemCounterMatrix::GetNNodes() const { return m_nodes; }
+
+uint16_t ItemCounterMatrix::GetNItems() const { return m_items; }
+
+bool ItemCounterMatrix::WriteCsv(const std::string& path) const {
+  std::ofstream out(path.c_str());
+  if (!out) {
+    return false;
+  }
+
+  out << "node,data_id";
+  for (uint32_t kind = 0; kind < NUM_KINDS; kind++) {
+    out << "," << KIND_NAMES[kind];
+  }
+  out << "\n";
+
+  // the matrix is mostly empty, so only the cells that counted something are written
+  for (uint32_t node = 0; node < m_nodes; node++) {
+    for (uint16_t dataID = 1; dataID <= m_items; dataID++) {
+      const uint16_t* counts = &m_counts[Index(node, dataID, HIT)];
+
+      bool empty = true;
+      for (uint32_t kind = 0; kind < NUM_KINDS; kind++) {
+        empty = empty && counts[kind] == 0;
+      }
+      if (empty) {
+        continue;
+      }
+
+      out << node << "," << dataID;
+      for (uint32_t kind = 0; kind < NUM_KINDS; kind++) {
+        out << "," << counts[kind];
+      }
+      out << "\n";
+    }
+  }
+
+  return out.good();
+}
+
+bool ItemCounterMatrix::WriteBinary(const std::string& path) const {
+  std::ofstream out(path.c_str(), std::ios::binary);
+  if (!out) {
+    return false;
+  }
+
+  out.write("SAFM", 4);
+  WriteU32(out, BINARY_VERSION);
+  WriteU32(out, m_nodes);
+  WriteU32(out, m_items);
+  WriteU32(out, NUM_KINDS);
+
+  // converted in one buffer so the byte order does not depend on the host
+  std::vector<char> bytes(m_counts.size() * 2);
+  for (size_t i = 0; i < m_counts.size(); i++) {
+    bytes[2 * i] = (char)(m_counts[i] & 0xff);
+    bytes[2 * i + 1] = (char)(m_counts[i] >> 8);
+  }
+  out.write(bytes.data(), bytes.size());
+
+  return out.good();
+}
+
+}  // namespace ns3
@@ -0,0 +1,63 @@
+#ifndef SAF_ITEM_COUNTER_MATRIX_H
+#define SAF_ITEM_COUNTER_MATRIX_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief Lookup outcomes counted per node and per data item.
+ *
+ * A dense node x item x kind array of 16 bit counters, which stop at 65535
+ * instead of wrapping. A hundred nodes and a thousand items take 800 KB.
+ *
+ * The matrix is written out in one go instead of going through a
+ * DataCalculator per cell, either as CSV with a row for every node and item
+ * that counted anything, or as a binary file with every cell.
+ *
+ * The binary file starts with the magic "SAFM" and then the version, number
+ * of nodes, number of items and number of kinds as little endian 32 bit
+ * integers, followed by the counters as little endian 16 bit integers,
+ * kinds varying fastest, then data IDs from 1, then node IDs from 0.
+ */
+class ItemCounterMatrix {
+ public:
+  enum Kind {
+    HIT,      // the item was found in the local store
+    MISS,     // the item had to be asked for, including lookups attached to a pending request
+    TIMEOUT,  // no response in time
+    LATE,     // a response after the timeout
+    NUM_KINDS
+  };
+
+  ItemCounterMatrix();
+  ~ItemCounterMatrix();
+
+  // size the matrix for data IDs 1 to totalItems and numNodes nodes, every counter is reset
+  void Init(uint32_t numNodes, uint16_t totalItems);
+
+  // nodes with an ID past the matrix grow it
+  void Increment(uint32_t nodeID, uint16_t dataID, Kind kind);
+
+  uint16_t Get(uint32_t nodeID, uint16_t dataID, Kind kind) const;
+
+  uint32_t GetNNodes() const;
+  uint16_t GetNItems() const;
+
+  // returns false if the file could not be written
+  bool WriteCsv(const std::string& path) const;
+  bool WriteBinary(const std::string& path) const;
+
+ private:
+  uint32_t Index(uint32_t nodeID, uint16_t dataID, Kind kind) const;
+
+  std::vector<uint16_t> m_counts;
+  uint32_t m_nodes;
+  uint16_t m_items;
+};
+
+}  // namespace ns3
+
+#endif /* SAF_ITEM_COUNTER_MATRIX_H */
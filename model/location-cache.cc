@@ -0,0 +1,92 @@
+
+#include "ns3/assert.h"
+
+#include "location-cache.h"
+
+namespace ns3 {
+
+LocationCache::LocationCache() { m_capacity = 0; }
+
+LocationCache::~LocationCache() {}
+
+void LocationCache::Init(uint16_t totalItems, uint16_t capacity) {
+  m_index.assign(totalItems + 1, 0);  // data IDs start at 1
+  m_entries.clear();
+  m_entries.reserve(capacity);
+  m_capacity = capacity;
+}
+
+void LocationCache::Learn(uint16_t dataID, Ipv4Address holder, Time now) {
+  NS_ASSERT_MSG(dataID != 0 && dataID < m_index.size(), "data ID is outside of the cache");
+
+  if (m_capacity == 0) {
+    return;
+  }
+
+  if (m_index[dataID] != 0) {
+    Entry& entry = m_entries[m_index[dataID] - 1];
+    entry.holder = holder;
+    entry.learned = now;
+    return;
+  }
+
+  if (m_entries.size() >= m_capacity) {
+    uint16_t oldest = 0;
+    for (uint16_t i = 1; i < m_entries.size(); i++) {
+      if (m_entries[i].learned < m_entries[oldest].learned) {
+        oldest = i;
+      }
+    }
+    Forget(m_entries[oldest].dataID);
+  }
+
+  Entry entry;
+  entry.dataID = dataID;
+  entry.holder = holder;
+  entry.learned = now;
+  m_entries.push_back(entry);
+  m_index[dataID] = m_entries.size();
+}
+
+bool LocationCache::Lookup(uint16_t dataID, Time notBefore, Ipv4Address& holder) const {
+  if (dataID >= m_index.size() || m_index[dataID] == 0) {
+    return false;
+  }
+
+  const Entry& entry = m_entries[m_index[dataID] - 1];
+  if (entry.learned < notBefore) {
+    return false;
+  }
+
+  holder = entry.holder;
+  return true;
+}
+
+bool LocationCache::Forget(uint16_t dataID) {
+  if (dataID >= m_index.size() || m_index[dataID] == 0) {
+    return false;
+  }
+
+  // move the last entry into the freed slot so the array stays compact
+  uint16_t slot = m_index[dataID] - 1;
+  if (slot != m_entries.size() - 1) {
+    m_entries[slot] = m_entries.back();
+    m_index[m_entries[slot].dataID] = slot + 1;
+  }
+  m_entries.pop_back();
+  m_index[dataID] = 0;
+  return true;
+}
+
+void LocationCache::Clear() {
+  for (std::vector<Entry>::const_iterator it = m_entries.begin(); it != m_entries.end(); ++it) {
+    m_index[it->dataID] = 0;
+  }
+  m_entries.clear();
+}
+
+uint16_t LocationCache::GetSize() const { return m_entries.size(); }
+
+uint16_t LocationCache::GetCapacity() const { return m_capacity; }
+
+}  // namespace ns3
@@ -0,0 +1,56 @@
+#ifndef SAF_LOCATION_CACHE_H
+#define SAF_LOCATION_CACHE_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "ns3/ipv4-address.h"
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+/**
+ * \brief The last known holder of data items, learned from responses.
+ *
+ * Holds at most capacity entries, when it is full the entry that was learned
+ * the longest ago makes room for the new one. Entries are looked up through
+ * an ID indexed slot table like DataStore, and only the eviction scans the
+ * entries, which is fine for the handful of them a node keeps.
+ */
+class LocationCache {
+ public:
+  LocationCache();
+  ~LocationCache();
+
+  // size the cache for data IDs 1 to totalItems, a capacity of 0 disables it
+  void Init(uint16_t totalItems, uint16_t capacity);
+
+  // remember that holder had the item at the given time
+  void Learn(uint16_t dataID, Ipv4Address holder, Time now);
+
+  // returns false if the holder is unknown or was learned before notBefore
+  bool Lookup(uint16_t dataID, Time notBefore, Ipv4Address& holder) const;
+
+  // returns false if the holder was not known
+  bool Forget(uint16_t dataID);
+
+  void Clear();
+
+  uint16_t GetSize() const;
+  uint16_t GetCapacity() const;
+
+ private:
+  struct Entry {
+    uint16_t dataID;
+    Ipv4Address holder;
+    Time learned;
+  };
+
+  std::vector<uint16_t> m_index;  // data ID -> slot + 1, 0 when the holder is not known
+  std::vector<Entry> m_entries;   // compact array of the known holders
+  uint16_t m_capacity;
+};
+
+}  // namespace ns3
+
+#endif /* SAF_LOCATION_CACHE_H */
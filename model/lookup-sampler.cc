@@ -0,0 +1,40 @@
+
+#include <algorithm>  // std::upper_bound
+
+#include "lookup-sampler.h"
+
+namespace ns3 {
+
+LookupSampler::LookupSampler() { m_last = 0; }
+
+LookupSampler::~LookupSampler() { m_last = 0; }
+
+void LookupSampler::Init(const std::vector<double>& means) {
+  m_cumulative.assign(means.size(), 0.0);
+  m_last = 0;
+
+  double total = 0.0;
+  for (size_t i = 0; i < means.size(); i++) {
+    if (means[i] > 0.0) {
+      total += 1.0 / means[i];
+      m_last = i + 1;
+    }
+    m_cumulative[i] = total;
+  }
+}
+
+double LookupSampler::GetTotalRate() const {
+  return m_cumulative.empty() ? 0.0 : m_cumulative.back();
+}
+
+uint16_t LookupSampler::Pick(double u) const {
+  // the first item whose running sum passes u, items without a rate have the
+  // same sum as the one before them so they are never the first to pass it
+  std::vector<double>::const_iterator it =
+      std::upper_bound(m_cumulative.begin(), m_cumulative.end(), u);
+
+  uint16_t dataID = (it - m_cumulative.begin()) + 1;
+  return dataID > m_last ? m_last : dataID;
+}
+
+}  // namespace ns3
@@ -0,0 +1,42 @@
+#ifndef SAF_LOOKUP_SAMPLER_H
+#define SAF_LOOKUP_SAMPLER_H
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief Picks which data item a node looks up next.
+ *
+ * The lookups of each data item are independent Poisson processes, so their
+ * superposition is a single Poisson process with the summed rate. The next
+ * lookup time can be drawn from the total rate and the item is then picked
+ * in proportion to its own rate, which only needs one pending event per node
+ * instead of one per data item.
+ */
+class LookupSampler {
+ public:
+  LookupSampler();
+  ~LookupSampler();
+
+  /**
+   * means[i] is the mean number of seconds between lookups of data ID i + 1,
+   * items with a mean of zero or less are never picked.
+   */
+  void Init(const std::vector<double>& means);
+
+  // the number of lookups per second summed over every data item
+  double GetTotalRate() const;
+
+  // maps u in [0, GetTotalRate()) to a data ID, 0 if nothing is looked up
+  uint16_t Pick(double u) const;
+
+ private:
+  std::vector<double> m_cumulative;  // running sum of the lookup rates by data ID - 1
+  uint16_t m_last;                   // the highest data ID with a lookup rate
+};
+
+}  // namespace ns3
+
+#endif /* SAF_LOOKUP_SAMPLER_H */
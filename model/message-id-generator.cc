@@ -0,0 +1,49 @@
+
+#include "ns3/assert.h"
+
+#include "logging.h"
+
+#include "message-id-generator.h"
+
+namespace ns3 {
+
+MessageIdGenerator::MessageIdGenerator() { Init(0, 1); }
+
+MessageIdGenerator::~MessageIdGenerator() {}
+
+void MessageIdGenerator::Init(uint32_t index, uint32_t numNodes) {
+  NS_ASSERT_MSG(index < numNodes, "the node index must be below the number of nodes");
+
+  // the bits needed for the largest index, at least one so that the shift stays below 32
+  uint32_t indexBits = 1;
+  while (indexBits < 32 && (numNodes - 1) >> indexBits != 0) {
+    indexBits++;
+  }
+  NS_ASSERT_MSG(indexBits < 32, "too many nodes to leave room for a message counter");
+
+  m_counter_bits = 32 - indexBits;
+  m_prefix = index << m_counter_bits;
+  m_next = 1;
+  m_wrapped = false;
+}
+
+uint32_t MessageIdGenerator::Next(uint16_t count) {
+  uint32_t limit = (uint32_t)1 << m_counter_bits;
+  NS_ASSERT_MSG(count < limit, "more IDs than the counter can hold");
+
+  // a batch never wraps around, so its IDs stay consecutive
+  if (m_next + count > limit) {
+    NS_LOG_WARN("message IDs of node " << (m_prefix >> m_counter_bits) << " start over");
+    m_next = 1;
+    m_wrapped = true;
+  }
+  uint32_t first = m_next;
+  m_next += count;
+  return m_prefix | first;
+}
+
+bool MessageIdGenerator::HasWrapped() const { return m_wrapped; }
+
+uint32_t MessageIdGenerator::GetCapacity() const { return ((uint32_t)1 << m_counter_bits) - 1; }
+
+}  // namespace ns3
@@ -0,0 +1,44 @@
+#ifndef SAF_MESSAGE_ID_GENERATOR_H
+#define SAF_MESSAGE_ID_GENERATOR_H
+
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \brief Hands out the message IDs of one node.
+ *
+ * The high bits of an ID hold the index of the node and the low bits count
+ * the messages of the node, so the IDs of different nodes never collide
+ * without the nodes sharing a counter. As few bits as needed for the number of
+ * nodes go to the index, leaving the rest for the counter, which starts over
+ * at 1 after it runs out. From then on an ID may still be in use by an old
+ * request, so the caller has to check HasWrapped and skip those.
+ */
+class MessageIdGenerator {
+ public:
+  MessageIdGenerator();
+  ~MessageIdGenerator();
+
+  // hand out the IDs of node index out of numNodes, starting over at the first one
+  void Init(uint32_t index, uint32_t numNodes);
+
+  // reserves count consecutive IDs and returns the first one
+  uint32_t Next(uint16_t count = 1);
+
+  // true once the counter started over, the IDs handed out may be in use since
+  bool HasWrapped() const;
+
+  // the number of IDs handed out before the counter starts over
+  uint32_t GetCapacity() const;
+
+ private:
+  uint32_t m_prefix;        // the index of the node, already shifted into place
+  uint32_t m_counter_bits;  // the number of low bits counting messages
+  uint32_t m_next;          // the counter of the next ID
+  bool m_wrapped;
+};
+
+}  // namespace ns3
+
+#endif /* SAF_MESSAGE_ID_GENERATOR_H */
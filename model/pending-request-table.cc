@@ -0,0 +1,126 @@
+
+#include "ns3/assert.h"
+
+#include "pending-request-table.h"
+
+namespace ns3 {
+
+PendingRequestTable::PendingRequestTable() {
+  m_size = 0;
+  m_bits = 0;
+  Resize(4);
+}
+
+PendingRequestTable::~PendingRequestTable() { m_size = 0; }
+
+void PendingRequestTable::Reserve(uint32_t count) {
+  uint32_t bits = m_bits;
+  while ((1u << bits) < 2 * count) {
+    bits++;
+  }
+  if (bits != m_bits) {
+    Resize(bits);
+  }
+}
+
+bool PendingRequestTable::Insert(const PendingRequest& request) {
+  NS_ASSERT_MSG(request.requestID != 0, "request ID 0 marks an empty slot");
+
+  // keep the table at most half full so probe sequences stay short
+  if (2 * (m_size + 1) > m_slots.size()) {
+    Resize(m_bits + 1);
+  }
+
+  uint32_t slot = Probe(request.requestID);
+  if (m_slots[slot].requestID != 0) {
+    return false;
+  }
+
+  m_slots[slot] = request;
+  m_size++;
+  return true;
+}
+
+const PendingRequest* PendingRequestTable::Find(uint32_t requestID) const {
+  if (requestID == 0) {
+    return 0;
+  }
+
+  uint32_t slot = Probe(requestID);
+  return m_slots[slot].requestID == 0 ? 0 : &m_slots[slot];
+}
+
+PendingRequest* PendingRequestTable::Find(uint32_t requestID) {
+  const PendingRequestTable* table = this;
+  return const_cast<PendingRequest*>(table->Find(requestID));
+}
+
+bool PendingRequestTable::Remove(uint32_t requestID, PendingRequest& removed) {
+  if (requestID == 0) {
+    return false;
+  }
+
+  uint32_t mask = m_slots.size() - 1;
+  uint32_t hole = Probe(requestID);
+  if (m_slots[hole].requestID == 0) {
+    return false;
+  }
+
+  removed = m_slots[hole];
+  m_size--;
+
+  // shift back every following entry that would no longer be reachable from
+  // its home slot once the hole is left empty
+  for (uint32_t next = (hole + 1) & mask; m_slots[next].requestID != 0; next = (next + 1) & mask) {
+    uint32_t home = Home(m_slots[next].requestID);
+    if (((next - home) & mask) >= ((next - hole) & mask)) {
+      m_slots[hole] = m_slots[next];
+      hole = next;
+    }
+  }
+
+  m_slots[hole].requestID = 0;
+  return true;
+}
+
+void PendingRequestTable::Clear() {
+  for (std::vector<PendingRequest>::iterator it = m_slots.begin(); it != m_slots.end(); ++it) {
+    it->requestID = 0;
+  }
+  m_size = 0;
+}
+
+uint32_t PendingRequestTable::GetSize() const { return m_size; }
+
+uint32_t PendingRequestTable::Home(uint32_t requestID) const {
+  // request IDs are sequential, fibonacci hashing spreads them over the table
+  return (uint32_t)(requestID * 2654435769u) >> (32 - m_bits);
+}
+
+uint32_t PendingRequestTable::Probe(uint32_t requestID) const {
+  uint32_t mask = m_slots.size() - 1;
+  uint32_t slot = Home(requestID);
+  while (m_slots[slot].requestID != 0 && m_slots[slot].requestID != requestID) {
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+void PendingRequestTable::Resize(uint32_t bits) {
+  std::vector<PendingRequest> old;
+  old.swap(m_slots);
+
+  PendingRequest empty = PendingRequest();
+  m_slots.assign(1u << bits, empty);
+  m_bits = bits;
+  m_size = 0;
+
+  for (std::vector<PendingRequest>::iterator it = old.begin(); it != old.end(); ++it) {
+    if (it->requestID != 0) {
+      m_slots[Probe(it->requestID)] = *it;
+      m_size++;
+    }
+  }
+}
+
+}  // namespace ns3
@@ -0,0 +1,74 @@
+#ifndef SAF_PENDING_REQUEST_TABLE_H
+#define SAF_PENDING_REQUEST_TABLE_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+/**
+ * \brief A request sent by this node that is still waiting for a response.
+ */
+struct PendingRequest {
+  uint32_t requestID;  // 0 when the slot is empty
+  uint16_t dataID;
+  uint8_t kind;
+  uint8_t retries;
+  uint16_t waiters;  // lookups of the same item that attached to this request
+  bool unicast;      // sent to the cached holder of the item instead of broadcast
+  uint8_t hopLimit;  // how far peers forward the request, 0 when they do not
+  Time sendTime;
+};
+
+/**
+ * \brief The requests a node is waiting on, keyed by request ID.
+ *
+ * This is an open addressed hash table using linear probing, so inserting and
+ * removing a request is O(1) and does not allocate. The table doubles when it
+ * gets half full, so after the first few requests its size stays fixed.
+ * Removal shifts the following entries back instead of leaving tombstones,
+ * which keeps lookups short no matter how many requests have come and gone.
+ */
+class PendingRequestTable {
+ public:
+  enum Kind { LOOKUP, REALLOCATION };
+
+  PendingRequestTable();
+  ~PendingRequestTable();
+
+  // size the table so that count requests fit without growing
+  void Reserve(uint32_t count);
+
+  // returns false if a request with the same ID is already pending
+  bool Insert(const PendingRequest& request);
+
+  // returns 0 if the request is not pending
+  const PendingRequest* Find(uint32_t requestID) const;
+  PendingRequest* Find(uint32_t requestID);
+
+  // returns false if the request was not pending, otherwise copies it to removed
+  bool Remove(uint32_t requestID, PendingRequest& removed);
+
+  void Clear();
+
+  uint32_t GetSize() const;
+
+ private:
+  // the slot a request ID hashes to
+  uint32_t Home(uint32_t requestID) const;
+
+  // the slot holding the request, or the empty slot where it would go
+  uint32_t Probe(uint32_t requestID) const;
+
+  void Resize(uint32_t bits);
+
+  std::vector<PendingRequest> m_slots;
+  uint32_t m_bits;  // m_slots holds 2^m_bits entries
+  uint32_t m_size;
+};
+
+}  // namespace ns3
+
+#endif /* SAF_PENDING_REQUEST_TABLE_H */
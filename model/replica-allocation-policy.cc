@@ -0,0 +1,459 @@
+
+#include <algorithm>  // std::min, std::stable_sort
+#include <deque>
+
+#include "ns3/assert.h"
+#include "ns3/double.h"
+#include "ns3/mobility-model.h"
+#include "ns3/simulator.h"
+
+#include "replica-allocation-policy.h"
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED(ReplicaAllocationPolicy);
+NS_OBJECT_ENSURE_REGISTERED(SafAllocationPolicy);
+NS_OBJECT_ENSURE_REGISTERED(DafnAllocationPolicy);
+NS_OBJECT_ENSURE_REGISTERED(DcgAllocationPolicy);
+
+namespace {
+
+// the biconnected components of a graph, found with Tarjan's algorithm
+struct BiconnectedSearch {
+  typedef std::pair<uint32_t, uint32_t> Edge;
+
+  const std::vector<std::vector<uint32_t>>* neighbors;
+  std::vector<int32_t> discovered;  // -1 until the node is visited
+  std::vector<int32_t> low;
+  std::vector<Edge> edges;
+  std::vector<std::vector<uint32_t>> components;
+  int32_t time;
+
+  void Visit(uint32_t u, uint32_t parent) {
+    discovered[u] = low[u] = time++;
+
+    const std::vector<uint32_t>& adjacent = (*neighbors)[u];
+    for (size_t i = 0; i < adjacent.size(); i++) {
+      uint32_t v = adjacent[i];
+      if (discovered[v] == -1) {
+        edges.push_back(Edge(u, v));
+        Visit(v, u);
+        low[u] = std::min(low[u], low[v]);
+
+        // u separates v from the rest, so every edge pushed since (u, v) is a component
+        if (low[v] >= discovered[u]) {
+          std::vector<uint32_t> component;
+          Edge edge;
+          do {
+            edge = edges.back();
+            edges.pop_back();
+            component.push_back(edge.first);
+            component.push_back(edge.second);
+          } while (edge != Edge(u, v));
+
+          std::sort(component.begin(), component.end());
+          component.erase(std::unique(component.begin(), component.end()), component.end());
+          components.push_back(component);
+        }
+      } else if (v != parent && discovered[v] < discovered[u]) {
+        edges.push_back(Edge(u, v));
+        low[u] = std::min(low[u], discovered[v]);
+      }
+    }
+  }
+};
+
+// orders components by their number of nodes, largest first
+struct LargerComponent {
+  bool operator()(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) const {
+    return a.size() > b.size();
+  }
+};
+
+// orders data IDs by their access rate over a group, highest first
+struct HigherGroupRate {
+  const std::vector<double>* rates;
+
+  bool operator()(uint16_t i, uint16_t j) const { return (*rates)[i] > (*rates)[j]; }
+};
+
+}  // namespace
+
+TypeId ReplicaAllocationPolicy::GetTypeId(void) {
+  static TypeId tid = TypeId("ns3::ReplicaAllocationPolicy")
+                          .SetParent<Object>()
+                          .SetGroupName("Applications")
+                          .AddAttribute(
+                              "Range",
+                              "The distance in meters within which two nodes are neighbors",
+                              DoubleValue(250.0),
+                              MakeDoubleAccessor(&ReplicaAllocationPolicy::m_range),
+                              MakeDoubleChecker<double>(0.0));
+  return tid;
+}
+
+ReplicaAllocationPolicy::ReplicaAllocationPolicy() {
+  m_range = 250.0;
+  m_allocated = false;
+}
+
+ReplicaAllocationPolicy::~ReplicaAllocationPolicy() {}
+
+Ptr<ReplicaAllocationPolicy> ReplicaAllocationPolicy::Create(Scheme scheme) {
+  switch (scheme) {
+    case DAFN:
+      return CreateObject<DafnAllocationPolicy>();
+    case DCG:
+      return CreateObject<DcgAllocationPolicy>();
+    default:
+      return CreateObject<SafAllocationPolicy>();
+  }
+}
+
+double ReplicaAllocationPolicy::GetRange() const { return m_range; }
+
+uint32_t ReplicaAllocationPolicy::AddMember(
+    Ptr<Node> node,
+    Ptr<SafCatalog> catalog,
+    const DataStore& originals,
+    uint16_t capacity) {
+  uint32_t index = 0;
+  while (index < m_members.size() && m_members[index].node != node) {
+    index++;
+  }
+  if (index == m_members.size()) {
+    m_members.push_back(Member());
+  }
+
+  Member& member = m_members[index];
+  member.node = node;
+  member.catalog = catalog;
+  member.capacity = capacity;
+  member.originals.Init(catalog->GetTotalItems());
+  member.allocated.Init(catalog->GetTotalItems());
+  member.previous.Init(catalog->GetTotalItems());
+  member.changed = true;
+  for (DataStore::Iterator it = originals.Begin(); it != originals.End(); ++it) {
+    member.originals.Insert(it->GetDataID());
+  }
+
+  // the next Allocate has to take the new member into account
+  m_allocated = false;
+  return index;
+}
+
+uint32_t ReplicaAllocationPolicy::GetNMembers() const { return m_members.size(); }
+
+bool ReplicaAllocationPolicy::IsStatic() const { return false; }
+
+bool ReplicaAllocationPolicy::Allocate(uint32_t member, DataIdSet& wanted) {
+  NS_ASSERT_MSG(member < m_members.size(), "not a member of the allocation");
+
+  if (!m_allocated || (!IsStatic() && m_allocated_at != Simulator::Now())) {
+    // the last allocation is kept aside so only the members it changed for are reported
+    for (size_t i = 0; i < m_members.size(); i++) {
+      m_members[i].previous.Swap(m_members[i].allocated);
+      m_members[i].allocated.Clear();
+    }
+    DoAllocate(m_members);
+    m_allocated = true;
+    m_allocated_at = Simulator::Now();
+
+    for (size_t i = 0; i < m_members.size(); i++) {
+      if (!SameSet(m_members[i].allocated, m_members[i].previous)) {
+        m_members[i].changed = true;
+      }
+    }
+  }
+
+  if (!m_members[member].changed) {
+    return false;
+  }
+  m_members[member].changed = false;
+
+  const std::vector<uint16_t>& allocated = m_members[member].allocated.GetMembers();
+  wanted.Clear();
+  for (size_t i = 0; i < allocated.size(); i++) {
+    wanted.Insert(allocated[i]);
+  }
+  return true;
+}
+
+void ReplicaAllocationPolicy::DoDispose(void) {
+  m_members.clear();
+  Object::DoDispose();
+}
+
+ReplicaAllocationPolicy::Neighbors ReplicaAllocationPolicy::GetNeighbors(
+    const std::vector<Member>& members) const {
+  std::vector<Ptr<MobilityModel>> mobility(members.size());
+  for (size_t i = 0; i < members.size(); i++) {
+    mobility[i] = members[i].node->GetObject<MobilityModel>();
+  }
+
+  Neighbors neighbors(members.size());
+  for (uint32_t i = 0; i < members.size(); i++) {
+    for (uint32_t j = i + 1; j < members.size(); j++) {
+      if (mobility[i] != 0 && mobility[j] != 0 &&
+          mobility[i]->GetDistanceFrom(mobility[j]) <= m_range) {
+        neighbors[i].push_back(j);
+        neighbors[j].push_back(i);
+      }
+    }
+  }
+  return neighbors;
+}
+
+double ReplicaAllocationPolicy::GetAccessRate(const Member& member, uint16_t dataID) {
+  double delay = member.catalog->GetLookupDelay(dataID);
+  return delay > 0.0 ? 1.0 / delay : 0.0;
+}
+
+bool ReplicaAllocationPolicy::SameSet(const DataIdSet& a, const DataIdSet& b) {
+  if (a.GetSize() != b.GetSize()) {
+    return false;
+  }
+
+  const std::vector<uint16_t>& members = a.GetMembers();
+  for (size_t i = 0; i < members.size(); i++) {
+    if (!b.Contains(members[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ReplicaAllocationPolicy::Holds(const Member& member, uint16_t dataID) {
+  return member.originals.Contains(dataID) || member.allocated.Contains(dataID);
+}
+
+void ReplicaAllocationPolicy::FillByFrequency(Member& member) {
+  uint16_t total = member.catalog->GetTotalItems();
+  for (uint16_t rank = 0; rank < total && member.allocated.GetSize() < member.capacity; rank++) {
+    uint16_t dataID = member.catalog->GetRanked(rank);
+    if (!Holds(member, dataID)) {
+      member.allocated.Insert(dataID);
+    }
+  }
+}
+
+// ---------------------------------------------------------------
+
+TypeId SafAllocationPolicy::GetTypeId(void) {
+  static TypeId tid = TypeId("ns3::SafAllocationPolicy")
+                          .SetParent<ReplicaAllocationPolicy>()
+                          .SetGroupName("Applications")
+                          .AddConstructor<SafAllocationPolicy>();
+  return tid;
+}
+
+ReplicaAllocationPolicy::Scheme SafAllocationPolicy::GetScheme() const { return SAF; }
+
+// the access frequencies never change, and SAF does not look at the positions
+bool SafAllocationPolicy::IsStatic() const { return true; }
+
+void SafAllocationPolicy::DoAllocate(std::vector<Member>& members) {
+  for (size_t i = 0; i < members.size(); i++) {
+    FillByFrequency(members[i]);
+  }
+}
+
+// ---------------------------------------------------------------
+
+TypeId DafnAllocationPolicy::GetTypeId(void) {
+  static TypeId tid = TypeId("ns3::DafnAllocationPolicy")
+                          .SetParent<ReplicaAllocationPolicy>()
+                          .SetGroupName("Applications")
+                          .AddConstructor<DafnAllocationPolicy>();
+  return tid;
+}
+
+ReplicaAllocationPolicy::Scheme DafnAllocationPolicy::GetScheme() const { return DAFN; }
+
+void DafnAllocationPolicy::DoAllocate(std::vector<Member>& members) {
+  for (size_t i = 0; i < members.size(); i++) {
+    FillByFrequency(members[i]);
+  }
+
+  // every pair of neighbors is handled once, in breadth first order
+  Neighbors neighbors = GetNeighbors(members);
+  std::vector<uint8_t> state(members.size(), 0);  // 0 unseen, 1 queued, 2 done
+  std::deque<uint32_t> queue;
+  for (uint32_t start = 0; start < members.size(); start++) {
+    if (state[start] != 0) {
+      continue;
+    }
+
+    state[start] = 1;
+    queue.push_back(start);
+    while (!queue.empty()) {
+      uint32_t u = queue.front();
+      queue.pop_front();
+      state[u] = 2;
+
+      for (size_t i = 0; i < neighbors[u].size(); i++) {
+        uint32_t v = neighbors[u][i];
+        if (state[v] == 2) {
+          continue;
+        }
+        RemoveDuplicates(members[u], members[v]);
+        if (state[v] == 0) {
+          state[v] = 1;
+          queue.push_back(v);
+        }
+      }
+    }
+  }
+}
+
+void DafnAllocationPolicy::RemoveDuplicates(Member& first, Member& second) {
+  // copied since replacing an item changes the allocation
+  std::vector<uint16_t> items = first.allocated.GetMembers();
+  for (size_t i = 0; i < items.size(); i++) {
+    uint16_t dataID = items[i];
+    if (second.originals.Contains(dataID)) {
+      Replace(first, dataID, second);
+    } else if (second.allocated.Contains(dataID)) {
+      // the second member gives it up when both access it equally
+      if (GetAccessRate(first, dataID) < GetAccessRate(second, dataID)) {
+        Replace(first, dataID, second);
+      } else {
+        Replace(second, dataID, first);
+      }
+    }
+  }
+
+  items = second.allocated.GetMembers();
+  for (size_t i = 0; i < items.size(); i++) {
+    if (first.originals.Contains(items[i])) {
+      Replace(second, items[i], first);
+    }
+  }
+}
+
+void DafnAllocationPolicy::Replace(Member& member, uint16_t dataID, const Member& other) {
+  member.allocated.Erase(dataID);
+
+  uint16_t total = member.catalog->GetTotalItems();
+  for (uint16_t rank = 0; rank < total; rank++) {
+    uint16_t candidate = member.catalog->GetRanked(rank);
+    if (candidate != dataID && !Holds(member, candidate) && !Holds(other, candidate)) {
+      member.allocated.Insert(candidate);
+      return;
+    }
+  }
+
+  // every other item is already held by one of them, so keep the duplicate
+  member.allocated.Insert(dataID);
+}
+
+// ---------------------------------------------------------------
+
+TypeId DcgAllocationPolicy::GetTypeId(void) {
+  static TypeId tid = TypeId("ns3::DcgAllocationPolicy")
+                          .SetParent<ReplicaAllocationPolicy>()
+                          .SetGroupName("Applications")
+                          .AddConstructor<DcgAllocationPolicy>();
+  return tid;
+}
+
+ReplicaAllocationPolicy::Scheme DcgAllocationPolicy::GetScheme() const { return DCG; }
+
+void DcgAllocationPolicy::DoAllocate(std::vector<Member>& members) {
+  std::vector<std::vector<uint32_t>> groups = FindGroups(GetNeighbors(members));
+  for (size_t i = 0; i < groups.size(); i++) {
+    AllocateGroup(members, groups[i]);
+  }
+}
+
+std::vector<std::vector<uint32_t>> DcgAllocationPolicy::FindGroups(
+    const Neighbors& neighbors) const {
+  BiconnectedSearch search;
+  search.neighbors = &neighbors;
+  search.discovered.assign(neighbors.size(), -1);
+  search.low.assign(neighbors.size(), 0);
+  search.time = 0;
+  for (uint32_t i = 0; i < neighbors.size(); i++) {
+    if (search.discovered[i] == -1) {
+      search.Visit(i, i);
+    }
+  }
+
+  // a node that separates components joins the largest of them, nodes without
+  // neighbors are on their own
+  std::stable_sort(search.components.begin(), search.components.end(), LargerComponent());
+  std::vector<bool> grouped(neighbors.size(), false);
+  std::vector<std::vector<uint32_t>> groups;
+  for (size_t c = 0; c < search.components.size(); c++) {
+    std::vector<uint32_t> group;
+    for (size_t i = 0; i < search.components[c].size(); i++) {
+      uint32_t node = search.components[c][i];
+      if (!grouped[node]) {
+        grouped[node] = true;
+        group.push_back(node);
+      }
+    }
+    if (!group.empty()) {
+      groups.push_back(group);
+    }
+  }
+  for (uint32_t i = 0; i < neighbors.size(); i++) {
+    if (!grouped[i]) {
+      groups.push_back(std::vector<uint32_t>(1, i));
+    }
+  }
+  return groups;
+}
+
+void DcgAllocationPolicy::AllocateGroup(
+    std::vector<Member>& members,
+    const std::vector<uint32_t>& group) {
+  uint16_t total = members[group[0]].catalog->GetTotalItems();
+
+  // the access rate of every item summed over the group, indexed by data ID
+  std::vector<double> rates(total + 1, 0.0);
+  std::vector<uint16_t> order;
+  order.reserve(total);
+  for (uint16_t dataID = 1; dataID <= total; dataID++) {
+    for (size_t i = 0; i < group.size(); i++) {
+      rates[dataID] += GetAccessRate(members[group[i]], dataID);
+    }
+    order.push_back(dataID);
+  }
+  HigherGroupRate higher;
+  higher.rates = &rates;
+  std::stable_sort(order.begin(), order.end(), higher);
+
+  for (size_t n = 0; n < order.size(); n++) {
+    uint16_t dataID = order[n];
+
+    // items owned by a member are already available in the group
+    bool owned = false;
+    for (size_t i = 0; i < group.size() && !owned; i++) {
+      owned = members[group[i]].originals.Contains(dataID);
+    }
+    if (owned) {
+      continue;
+    }
+
+    Member* best = 0;
+    for (size_t i = 0; i < group.size(); i++) {
+      Member& member = members[group[i]];
+      if (member.allocated.GetSize() < member.capacity &&
+          (best == 0 || GetAccessRate(member, dataID) > GetAccessRate(*best, dataID))) {
+        best = &member;
+      }
+    }
+
+    if (best == 0) {
+      break;  // every member of the group is full
+    }
+    best->allocated.Insert(dataID);
+  }
+
+  for (size_t i = 0; i < group.size(); i++) {
+    FillByFrequency(members[group[i]]);
+  }
+}
+
+}  // namespace ns3
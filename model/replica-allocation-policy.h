@@ -0,0 +1,186 @@
+#ifndef SAF_REPLICA_ALLOCATION_POLICY_H
+#define SAF_REPLICA_ALLOCATION_POLICY_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "ns3/node.h"
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+
+#include "data-id-set.h"
+#include "data-store.h"
+#include "saf-catalog.h"
+
+namespace ns3 {
+
+/**
+ * \brief Decides which replicas every node holds in a relocation period.
+ *
+ * The allocation methods from Hara's "Effective Replica Allocation in Ad Hoc
+ * Networks for Improving Data Accessibility". Every node taking part is added
+ * as a member, and the first Allocate call of a relocation period computes
+ * the allocation of all of them at once. SAF only looks at the node itself,
+ * so every application can use its own policy, while DAFN and DCG look at the
+ * neighbors of a node and have to be shared between the applications, which
+ * SafApplicationHelper takes care of.
+ *
+ * Two members are neighbors when their mobility models are within Range of
+ * each other at the time of the allocation. Nodes without a mobility model
+ * have no neighbors.
+ */
+class ReplicaAllocationPolicy : public Object {
+ public:
+  enum Scheme { SAF, DAFN, DCG };
+
+  static TypeId GetTypeId(void);
+
+  ReplicaAllocationPolicy();
+  virtual ~ReplicaAllocationPolicy();
+
+  // a new policy of the given scheme
+  static Ptr<ReplicaAllocationPolicy> Create(Scheme scheme);
+
+  virtual Scheme GetScheme() const = 0;
+
+  // true if the allocation only changes when members are added and not when they move
+  virtual bool IsStatic() const;
+
+  double GetRange() const;
+
+  /**
+   * Add a node that holds replicas, adding the same node again only updates it.
+   *
+   * \param node The node, used for its position.
+   * \param catalog The access frequencies of the data items at the node.
+   * \param originals The original data items owned by the node.
+   * \param capacity The number of replicas the node can hold.
+   * \returns The member index to pass to Allocate.
+   */
+  uint32_t AddMember(
+      Ptr<Node> node,
+      Ptr<SafCatalog> catalog,
+      const DataStore& originals,
+      uint16_t capacity);
+
+  uint32_t GetNMembers() const;
+
+  /**
+   * Get the replicas the member should hold for the current period.
+   *
+   * \param member The member index returned by AddMember.
+   * \param wanted Set to the allocation of the member when it changed.
+   * \returns false if the allocation is the same as at the last call for the
+   * member, wanted is left as it is then.
+   */
+  bool Allocate(uint32_t member, DataIdSet& wanted);
+
+ protected:
+  struct Member {
+    Ptr<Node> node;
+    Ptr<SafCatalog> catalog;
+    uint16_t capacity;
+    DataIdSet originals;
+    DataIdSet allocated;
+    DataIdSet previous;  // the allocation before the last one was computed
+    bool changed;        // since the member last asked for its allocation
+  };
+
+  typedef std::vector<std::vector<uint32_t>> Neighbors;
+
+  virtual void DoDispose(void);
+
+  // compute the allocation of every member, the allocated sets start out empty
+  virtual void DoAllocate(std::vector<Member>& members) = 0;
+
+  // the members in range of each member, in member order
+  Neighbors GetNeighbors(const std::vector<Member>& members) const;
+
+  // the number of lookups of the item per second at the member
+  static double GetAccessRate(const Member& member, uint16_t dataID);
+
+  static bool SameSet(const DataIdSet& a, const DataIdSet& b);
+
+  // true if the member holds the item either as an original or as a replica
+  static bool Holds(const Member& member, uint16_t dataID);
+
+  // fill the free space of the member with the most frequently accessed items it does not hold
+  static void FillByFrequency(Member& member);
+
+ private:
+  double m_range;
+
+  std::vector<Member> m_members;
+  bool m_allocated;  // the allocation is only computed once per period
+  Time m_allocated_at;
+};
+
+/**
+ * \brief Static Access Frequency, every node holds the items it accesses most.
+ */
+class SafAllocationPolicy : public ReplicaAllocationPolicy {
+ public:
+  static TypeId GetTypeId(void);
+
+  virtual Scheme GetScheme() const;
+
+  virtual bool IsStatic() const;
+
+ protected:
+  virtual void DoAllocate(std::vector<Member>& members);
+};
+
+/**
+ * \brief Dynamic Access Frequency and Neighborhood.
+ *
+ * Starts from the SAF allocation and then walks the network breadth first
+ * from the first member. When two neighbors hold the same item the one that
+ * accesses it less, or the one that does not own it, replaces it with the
+ * most frequently accessed item neither of them holds.
+ */
+class DafnAllocationPolicy : public ReplicaAllocationPolicy {
+ public:
+  static TypeId GetTypeId(void);
+
+  virtual Scheme GetScheme() const;
+
+ protected:
+  virtual void DoAllocate(std::vector<Member>& members);
+
+ private:
+  void RemoveDuplicates(Member& first, Member& second);
+
+  // replace the item held by member with one neither member nor other holds
+  void Replace(Member& member, uint16_t dataID, const Member& other);
+};
+
+/**
+ * \brief Dynamic Connectivity based Grouping.
+ *
+ * Groups the members into the biconnected components of the network, a node
+ * in more than one of them joins the largest. Every group
+ * then allocates the items in order of their summed access frequency over the
+ * group, each to the member that accesses it most and still has space, and
+ * skips the items owned by a member of the group. Space left over after every
+ * item is allocated is filled like SAF.
+ */
+class DcgAllocationPolicy : public ReplicaAllocationPolicy {
+ public:
+  static TypeId GetTypeId(void);
+
+  virtual Scheme GetScheme() const;
+
+ protected:
+  virtual void DoAllocate(std::vector<Member>& members);
+
+ private:
+  // the members of every biconnected component
+  std::vector<std::vector<uint32_t>> FindGroups(const Neighbors& neighbors) const;
+
+  void AllocateGroup(std::vector<Member>& members, const std::vector<uint32_t>& group);
+};
+
+}  // namespace ns3
+
+#endif /* SAF_REPLICA_ALLOCATION_POLICY_H */
@@ -0,0 +1,112 @@
+
+#include "ns3/assert.h"
+
+#include "replica-heap.h"
+
+namespace ns3 {
+
+ReplicaHeap::ReplicaHeap() {}
+
+ReplicaHeap::~ReplicaHeap() {}
+
+void ReplicaHeap::Init(uint16_t totalItems) {
+  m_index.assign(totalItems + 1, 0);  // data IDs start at 1
+  m_heap.clear();
+  m_heap.reserve(totalItems);
+}
+
+bool ReplicaHeap::Contains(uint16_t dataID) const {
+  return dataID < m_index.size() && m_index[dataID] != 0;
+}
+
+bool ReplicaHeap::Insert(uint16_t dataID, uint32_t rank) {
+  NS_ASSERT_MSG(dataID != 0 && dataID < m_index.size(), "data ID is outside of the heap");
+
+  if (Contains(dataID)) {
+    return false;
+  }
+
+  Entry entry;
+  entry.dataID = dataID;
+  entry.rank = rank;
+  m_heap.push_back(entry);
+  m_index[dataID] = m_heap.size();
+  SiftUp(m_heap.size() - 1);
+  return true;
+}
+
+bool ReplicaHeap::Remove(uint16_t dataID) {
+  if (!Contains(dataID)) {
+    return false;
+  }
+
+  // move the last entry into the freed position and restore the heap from there
+  uint16_t i = m_index[dataID] - 1;
+  m_index[dataID] = 0;
+  Entry last = m_heap.back();
+  m_heap.pop_back();
+  if (i < m_heap.size()) {
+    Place(i, last);
+    SiftUp(i);
+    SiftDown(m_index[last.dataID] - 1);
+  }
+  return true;
+}
+
+uint16_t ReplicaHeap::GetLowest() const {
+  NS_ASSERT_MSG(!m_heap.empty(), "the heap is empty");
+  return m_heap[0].dataID;
+}
+
+uint32_t ReplicaHeap::GetLowestRank() const {
+  NS_ASSERT_MSG(!m_heap.empty(), "the heap is empty");
+  return m_heap[0].rank;
+}
+
+void ReplicaHeap::Clear() {
+  for (std::vector<Entry>::const_iterator it = m_heap.begin(); it != m_heap.end(); ++it) {
+    m_index[it->dataID] = 0;
+  }
+  m_heap.clear();
+}
+
+uint16_t ReplicaHeap::GetSize() const { return m_heap.size(); }
+
+bool ReplicaHeap::IsEmpty() const { return m_heap.empty(); }
+
+void ReplicaHeap::Place(uint16_t i, const Entry& entry) {
+  m_heap[i] = entry;
+  m_index[entry.dataID] = i + 1;
+}
+
+void ReplicaHeap::SiftUp(uint16_t i) {
+  Entry entry = m_heap[i];
+  while (i > 0) {
+    uint16_t parent = (i - 1) / 2;
+    if (m_heap[parent].rank >= entry.rank) {
+      break;
+    }
+    Place(i, m_heap[parent]);
+    i = parent;
+  }
+  Place(i, entry);
+}
+
+void ReplicaHeap::SiftDown(uint16_t i) {
+  Entry entry = m_heap[i];
+  uint32_t size = m_heap.size();
+  while (2u * i + 1 < size) {
+    uint32_t child = 2u * i + 1;
+    if (child + 1 < size && m_heap[child + 1].rank > m_heap[child].rank) {
+      child++;
+    }
+    if (m_heap[child].rank <= entry.rank) {
+      break;
+    }
+    Place(i, m_heap[child]);
+    i = child;
+  }
+  Place(i, entry);
+}
+
+}  // namespace ns3
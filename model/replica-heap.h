@@ -0,0 +1,61 @@
+#ifndef SAF_REPLICA_HEAP_H
+#define SAF_REPLICA_HEAP_H
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief The replicas held by a node, ordered by their access frequency rank.
+ *
+ * A binary min-heap on access frequency, so the top is always the least
+ * frequently accessed replica, which is the one to evict when a better ranked
+ * item arrives. Rank 0 is the most frequently accessed item, so the top holds
+ * the largest rank. An ID indexed position table lets any replica be removed
+ * in O(log n) and not only the top.
+ */
+class ReplicaHeap {
+ public:
+  ReplicaHeap();
+  ~ReplicaHeap();
+
+  // size the heap for data IDs 1 to totalItems, any members are dropped
+  void Init(uint16_t totalItems);
+
+  bool Contains(uint16_t dataID) const;
+
+  // returns false if the ID is already a member
+  bool Insert(uint16_t dataID, uint32_t rank);
+
+  // returns false if the ID was not a member
+  bool Remove(uint16_t dataID);
+
+  // the least frequently accessed member and its rank, the heap must not be empty
+  uint16_t GetLowest() const;
+  uint32_t GetLowestRank() const;
+
+  void Clear();
+
+  uint16_t GetSize() const;
+  bool IsEmpty() const;
+
+ private:
+  struct Entry {
+    uint16_t dataID;
+    uint32_t rank;
+  };
+
+  // put the entry at position i and update its index
+  void Place(uint16_t i, const Entry& entry);
+
+  void SiftUp(uint16_t i);
+  void SiftDown(uint16_t i);
+
+  std::vector<uint16_t> m_index;  // data ID -> position + 1, 0 when the ID is not a member
+  std::vector<Entry> m_heap;      // the largest rank is at position 0
+};
+
+}  // namespace ns3
+
+#endif /* SAF_REPLICA_HEAP_H */
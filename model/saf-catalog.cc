@@ -0,0 +1,118 @@
+
+#include <math.h>     // std::pow
+#include <algorithm>  // std::stable_sort
+
+#include "ns3/assert.h"
+
+#include "logging.h"
+
+#include "saf-catalog.h"
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED(SafCatalog);
+
+namespace {
+
+// orders data IDs by their lookup delay, shortest first
+struct ShorterLookupDelay {
+  const std::vector<double>* delays;
+
+  bool operator()(uint16_t i, uint16_t j) const {
+    return (*delays)[i - 1] < (*delays)[j - 1];
+  }
+};
+
+}  // namespace
+
+TypeId SafCatalog::GetTypeId(void) {
+  static TypeId tid = TypeId("ns3::SafCatalog")
+                          .SetParent<Object>()
+                          .SetGroupName("Applications")
+                          .AddConstructor<SafCatalog>();
+  return tid;
+}
+
+SafCatalog::SafCatalog() {
+  m_mode = 0;
+  m_standard_deviation = 0.0;
+}
+
+SafCatalog::~SafCatalog() {}
+
+void SafCatalog::Init(
+    uint16_t totalItems,
+    uint16_t mode,
+    double standardDeviation,
+    Time period,
+    Ptr<NormalRandomVariable> stream) {
+  m_mode = mode;
+  m_standard_deviation = standardDeviation;
+  m_period = period;
+
+  if (m_mode == 3 && stream == 0) {
+    stream = CreateObject<NormalRandomVariable>();
+  }
+
+  m_lookup_delays.resize(totalItems);
+  m_ranking.resize(totalItems);
+  for (uint16_t i = 1; i <= totalItems; i++) {
+    double accessFrequency = CalculateAccessFrequency(i, stream);
+    m_lookup_delays[i - 1] = period.GetSeconds() - (period.GetSeconds() * accessFrequency);
+    m_ranking[i - 1] = i;
+  }
+
+  // the most frequently accessed items are the ones looked up most often
+  ShorterLookupDelay order;
+  order.delays = &m_lookup_delays;
+  std::stable_sort(m_ranking.begin(), m_ranking.end(), order);
+
+  m_ranks.resize(totalItems);
+  for (uint16_t rank = 0; rank < totalItems; rank++) {
+    m_ranks[m_ranking[rank] - 1] = rank;
+  }
+}
+
+bool SafCatalog::IsShareable(uint16_t mode) { return mode == 1 || mode == 2; }
+
+bool SafCatalog::Matches(
+    uint16_t totalItems,
+    uint16_t mode,
+    double standardDeviation,
+    Time period) const {
+  return m_lookup_delays.size() == totalItems && m_mode == mode &&
+         m_standard_deviation == standardDeviation && m_period == period;
+}
+
+uint16_t SafCatalog::GetTotalItems() const { return m_lookup_delays.size(); }
+
+double SafCatalog::GetLookupDelay(uint16_t dataID) const {
+  NS_ASSERT_MSG(dataID != 0 && dataID <= m_lookup_delays.size(), "data ID is outside of catalog");
+  return m_lookup_delays[dataID - 1];
+}
+
+const std::vector<double>& SafCatalog::GetLookupDelays() const { return m_lookup_delays; }
+
+uint16_t SafCatalog::GetRanked(uint16_t rank) const { return m_ranking[rank]; }
+
+uint16_t SafCatalog::GetRank(uint16_t dataID) const {
+  NS_ASSERT_MSG(dataID != 0 && dataID <= m_ranks.size(), "data ID is outside of catalog");
+  return m_ranks[dataID - 1];
+}
+
+double SafCatalog::CalculateAccessFrequency(
+    uint16_t dataID,
+    Ptr<NormalRandomVariable> stream) const {
+  if (m_mode == 1) {
+    return 0.5 * (1.0 + 0.01 * dataID);
+  } else if (m_mode == 2) {
+    return 0.025 * dataID;
+  } else if (m_mode == 3) {
+    return stream->GetValue(0.5 * (1.0 + 0.01 * dataID), pow(m_standard_deviation, 2.0));
+  } else {
+    NS_LOG_ERROR("this is bad, the access frequency mode must be 1, 2, or 3");
+    return 0;
+  }
+}
+
+}  // namespace ns3
@@ -0,0 +1,76 @@
+#ifndef SAF_CATALOG_H
+#define SAF_CATALOG_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/random-variable-stream.h"
+
+namespace ns3 {
+
+/**
+ * \brief The access frequency of every data item and their ranking.
+ *
+ * In access frequency modes 1 and 2 every node sees the same frequencies, so
+ * SafApplicationHelper builds one catalog and shares it with every application
+ * it installs. In mode 3 the frequencies are drawn per node and each
+ * application builds its own.
+ */
+class SafCatalog : public Object {
+ public:
+  static TypeId GetTypeId(void);
+
+  SafCatalog();
+  virtual ~SafCatalog();
+
+  /**
+   * Compute the access frequencies of data IDs 1 to totalItems for the given
+   * access frequency mode and rank them from most to least frequently accessed.
+   * Mode 3 draws every frequency from the given stream, or from a new one if
+   * none is given.
+   */
+  void Init(
+      uint16_t totalItems,
+      uint16_t mode,
+      double standardDeviation,
+      Time period,
+      Ptr<NormalRandomVariable> stream = 0);
+
+  // true if the frequencies do not depend on the node they are computed for
+  static bool IsShareable(uint16_t mode);
+
+  // true if Init was called with the same arguments
+  bool Matches(uint16_t totalItems, uint16_t mode, double standardDeviation, Time period) const;
+
+  uint16_t GetTotalItems() const;
+
+  // the mean number of seconds between lookups of the item
+  double GetLookupDelay(uint16_t dataID) const;
+
+  // indexed by data ID - 1
+  const std::vector<double>& GetLookupDelays() const;
+
+  // the data ID with the given rank, rank 0 is the most frequently accessed item
+  uint16_t GetRanked(uint16_t rank) const;
+
+  // the rank of the data ID, the inverse of GetRanked
+  uint16_t GetRank(uint16_t dataID) const;
+
+ private:
+  double CalculateAccessFrequency(uint16_t dataID, Ptr<NormalRandomVariable> stream) const;
+
+  uint16_t m_mode;
+  double m_standard_deviation;
+  Time m_period;
+
+  std::vector<double> m_lookup_delays;  // data ID - 1 -> mean seconds between lookups
+  std::vector<uint16_t> m_ranking;      // data IDs from most to least frequently accessed
+  std::vector<uint16_t> m_ranks;        // data ID - 1 -> rank
+};
+
+}  // namespace ns3
+
+#endif /* SAF_CATALOG_H */
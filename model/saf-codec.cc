@@ -0,0 +1,380 @@
+
+#include <algorithm>  // std::min
+
+#include "ns3/assert.h"
+#include "ns3/fatal-error.h"
+
+#include "logging.h"
+
+#include "saf-codec.h"
+
+#ifdef SAF_HAVE_PROTOBUF
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
+
+#include "proto/message.pb.h"
+
+using google::protobuf::internal::WireFormatLite;
+using google::protobuf::io::CodedInputStream;
+#endif
+
+namespace ns3 {
+
+#ifdef SAF_HAVE_PROTOBUF
+namespace {
+
+// reads a batched response item into message, skipping over its data bytes
+bool ReadItem(CodedInputStream& input, SafHeader& message) {
+  uint32_t length;
+  if (!input.ReadVarint32(&length)) {
+    return false;
+  }
+
+  uint32_t dataID = 0;
+  uint32_t offset = 0;
+  uint32_t size = 0;
+
+  CodedInputStream::Limit limit = input.PushLimit(length);
+  uint32_t tag;
+  while ((tag = input.ReadTag()) != 0) {
+    int field = WireFormatLite::GetTagFieldNumber(tag);
+    WireFormatLite::WireType type = WireFormatLite::GetTagWireType(tag);
+
+    if (field == saf::packets::Item::kDataIdFieldNumber &&
+        type == WireFormatLite::WIRETYPE_VARINT) {
+      if (!input.ReadVarint32(&dataID)) return false;
+    } else if (
+        field == saf::packets::Item::kOffsetFieldNumber &&
+        type == WireFormatLite::WIRETYPE_VARINT) {
+      if (!input.ReadVarint32(&offset)) return false;
+    } else if (
+        field == saf::packets::Item::kDataFieldNumber &&
+        type == WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+      if (!input.ReadVarint32(&size) || !input.Skip(size)) return false;
+    } else if (!WireFormatLite::SkipField(&input, tag)) {
+      return false;
+    }
+  }
+
+  bool ok = input.ConsumedEntireMessage();
+  input.PopLimit(limit);
+  message.AddItem(dataID, offset, size);
+  return ok;
+}
+
+// reads the data IDs of a batched request, they are packed unless the sender
+// chose otherwise so both encodings are accepted
+bool ReadDataIDs(CodedInputStream& input, WireFormatLite::WireType type, SafHeader& message) {
+  uint32_t dataID;
+  if (type == WireFormatLite::WIRETYPE_VARINT) {
+    if (!input.ReadVarint32(&dataID)) return false;
+    message.AddItem(dataID, message.GetItemCount(), 0);
+    return true;
+  }
+
+  uint32_t length;
+  if (type != WireFormatLite::WIRETYPE_LENGTH_DELIMITED || !input.ReadVarint32(&length)) {
+    return false;
+  }
+
+  CodedInputStream::Limit limit = input.PushLimit(length);
+  while (input.BytesUntilLimit() > 0) {
+    if (!input.ReadVarint32(&dataID)) return false;
+    message.AddItem(dataID, message.GetItemCount(), 0);
+  }
+  input.PopLimit(limit);
+  return true;
+}
+
+// reads the fields of a request or response sub-message into message, the data
+// bytes of a response are skipped over since only their size is needed
+bool ReadPayload(CodedInputStream& input, SafHeader& message) {
+  uint32_t length;
+  if (!input.ReadVarint32(&length)) {
+    return false;
+  }
+
+  CodedInputStream::Limit limit = input.PushLimit(length);
+  uint32_t tag;
+  while ((tag = input.ReadTag()) != 0) {
+    int field = WireFormatLite::GetTagFieldNumber(tag);
+    WireFormatLite::WireType type = WireFormatLite::GetTagWireType(tag);
+
+    uint64_t value;
+    uint32_t size;
+    if (field == saf::packets::Request::kDataIdFieldNumber &&
+        type == WireFormatLite::WIRETYPE_VARINT) {
+      if (!input.ReadVarint64(&value)) return false;
+      message.SetDataID(value);
+    } else if (
+        field == saf::packets::Request::kReplicationRequestFieldNumber &&
+        type == WireFormatLite::WIRETYPE_VARINT) {
+      if (!input.ReadVarint64(&value)) return false;
+      message.SetReplication(value != 0);
+    } else if (
+        field == saf::packets::Request::kHopsFieldNumber &&
+        type == WireFormatLite::WIRETYPE_VARINT) {
+      if (!input.ReadVarint64(&value)) return false;
+      message.SetHops(value);
+    } else if (
+        field == saf::packets::Request::kHopLimitFieldNumber &&
+        type == WireFormatLite::WIRETYPE_VARINT) {
+      if (!input.ReadVarint64(&value)) return false;
+      message.SetHopLimit(value);
+    } else if (
+        message.IsResponse() && field == saf::packets::Response::kDataFieldNumber &&
+        type == WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+      if (!input.ReadVarint32(&size) || !input.Skip(size)) return false;
+      message.SetDataSize(message.GetDataSize() + size);
+    } else if (
+        !message.IsResponse() && field == saf::packets::Request::kDataIdsFieldNumber) {
+      if (!ReadDataIDs(input, type, message)) return false;
+    } else if (
+        message.IsResponse() && field == saf::packets::Response::kItemsFieldNumber &&
+        type == WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+      if (!ReadItem(input, message)) return false;
+    } else if (!WireFormatLite::SkipField(&input, tag)) {
+      return false;
+    }
+  }
+
+  bool ok = input.ConsumedEntireMessage();
+  input.PopLimit(limit);
+  return ok;
+}
+
+}  // namespace
+
+// requests and responses share the numbering of their common fields
+static_assert(
+    (int)saf::packets::Request::kDataIdFieldNumber ==
+            (int)saf::packets::Response::kDataIdFieldNumber &&
+        (int)saf::packets::Request::kReplicationRequestFieldNumber ==
+            (int)saf::packets::Response::kReplicationRequestFieldNumber &&
+        (int)saf::packets::Request::kHopsFieldNumber ==
+            (int)saf::packets::Response::kHopsFieldNumber &&
+        (int)saf::packets::Request::kHopLimitFieldNumber ==
+            (int)saf::packets::Response::kHopLimitFieldNumber,
+    "request and response field numbers must match");
+#endif
+
+SafCodec::SafCodec() {
+  m_format = GetDefaultWireFormat();
+  m_copied = 0;
+  m_tx_request = 0;
+  m_tx_response = 0;
+  m_arena = 0;
+
+#ifdef SAF_HAVE_PROTOBUF
+  // the messages live for as long as the codec and are reused for every packet,
+  // the message types are fixed so the payload is only allocated once
+  m_arena = new google::protobuf::Arena();
+  m_tx_request = google::protobuf::Arena::CreateMessage<saf::packets::Message>(m_arena);
+  m_tx_response = google::protobuf::Arena::CreateMessage<saf::packets::Message>(m_arena);
+  m_tx_request->mutable_request();
+  m_tx_response->mutable_response();
+#endif
+}
+
+SafCodec::~SafCodec() {
+#ifdef SAF_HAVE_PROTOBUF
+  delete m_arena;
+#endif
+  m_arena = 0;
+  m_tx_request = 0;
+  m_tx_response = 0;
+}
+
+SafCodec::WireFormat SafCodec::GetDefaultWireFormat() {
+#ifdef SAF_HAVE_PROTOBUF
+  return PROTOBUF;
+#else
+  return HEADER;
+#endif
+}
+
+bool SafCodec::IsSupported(WireFormat format) {
+#ifdef SAF_HAVE_PROTOBUF
+  return true;
+#else
+  return format == HEADER;
+#endif
+}
+
+void SafCodec::SetWireFormat(WireFormat format) {
+  if (!IsSupported(format)) {
+    NS_FATAL_ERROR("The saf module was built without protobuf support");
+  }
+  m_format = format;
+}
+
+SafCodec::WireFormat SafCodec::GetWireFormat() const { return m_format; }
+
+void SafCodec::Reserve(uint32_t dataSize) {
+  // large enough for a response carrying a data item, grown on demand otherwise
+  m_rx_buffer.reserve(dataSize + 64);
+  m_tx_buffer.reserve(dataSize + 64);
+}
+
+Ptr<Packet> SafCodec::Encode(const SafHeader& message) {
+  if (m_format == PROTOBUF) {
+    return EncodeProtobuf(message);
+  }
+
+  // the data bytes do not matter only their size, so use the zero filled payload
+  Ptr<Packet> packet = Create<Packet>(message.IsResponse() ? message.GetDataSize() : 0);
+  packet->AddHeader(message);
+  return packet;
+}
+
+bool SafCodec::Decode(Ptr<const Packet> packet, SafHeader& message) {
+  uint32_t size = packet->GetSize();
+
+  if (m_format == HEADER) {
+    // the flags decide which optional fields follow the fixed ones, so the size
+    // of the header is checked from its first bytes before any of it is read
+    uint8_t prefix[SafHeader::PREFIX_SIZE];
+    uint32_t length = std::min(size, SafHeader::PREFIX_SIZE);
+    packet->CopyData(prefix, length);
+    m_copied = length;
+
+    uint32_t headerSize = SafHeader::PeekSerializedSize(prefix, length);
+    if (headerSize == 0 || size < headerSize) {
+      return false;
+    }
+
+    // only the header is read out of the packet, the data bytes stay where they are
+    m_copied += packet->PeekHeader(message);
+    return size - m_copied == (message.IsResponse() ? message.GetDataSize() : 0);
+  }
+
+  // the scratch buffer only ever grows, so once it fits the largest message
+  // received packets are parsed without touching the heap
+  if (m_rx_buffer.size() < size) {
+    m_rx_buffer.resize(size);
+  }
+
+  packet->CopyData(m_rx_buffer.data(), size);
+  m_copied = size;
+
+  return DecodeProtobuf(m_rx_buffer.data(), size, message);
+}
+
+uint32_t SafCodec::GetCopiedBytes() const { return m_copied; }
+
+Ptr<Packet> SafCodec::EncodeProtobuf(const SafHeader& message) {
+#ifdef SAF_HAVE_PROTOBUF
+  // every field of the reused messages is overwritten here
+  saf::packets::Message* send;
+  if (message.IsResponse()) {
+    send = m_tx_response;
+    saf::packets::Response* resp = send->mutable_response();
+    resp->set_data_id(message.GetDataID());
+    resp->set_replication_request(message.IsReplication());
+    resp->set_hops(message.GetHops());
+    resp->set_hop_limit(message.GetHopLimit());
+
+    // cleared items are kept by the repeated field and reused by the next batch
+    resp->mutable_items()->Clear();
+    if (message.IsBatch()) {
+      resp->mutable_data()->clear();
+      for (uint16_t i = 0; i < message.GetItemCount(); i++) {
+        const SafHeader::Item& item = message.GetItem(i);
+        saf::packets::Item* added = resp->add_items();
+        added->set_data_id(item.dataID);
+        added->set_offset(item.offset);
+        added->mutable_data()->resize(item.size);
+      }
+    } else {
+      resp->mutable_data()->resize(message.GetDataSize());
+    }
+  } else {
+    send = m_tx_request;
+    saf::packets::Request* req = send->mutable_request();
+    req->set_data_id(message.GetDataID());
+    req->set_replication_request(message.IsReplication());
+    req->set_hops(message.GetHops());
+    req->set_hop_limit(message.GetHopLimit());
+
+    req->mutable_data_ids()->Clear();
+    for (uint16_t i = 0; i < message.GetItemCount(); i++) {
+      req->add_data_ids(message.GetItem(i).dataID);
+    }
+  }
+
+  send->set_id(message.GetId());
+  send->set_response_to(message.GetResponseTo());
+  send->set_original_sent_at(message.GetOriginalSentAt());
+  send->set_timestamp(message.GetTimestamp());
+
+  // ns-3 packets do not expose their storage for writing, so serialize into the
+  // reused buffer and let the packet take its one copy from there
+  uint32_t size = send->ByteSizeLong();
+  if (m_tx_buffer.size() < size) {
+    m_tx_buffer.resize(size);
+  }
+
+  send->SerializeWithCachedSizesToArray(m_tx_buffer.data());
+  return Create<Packet>(m_tx_buffer.data(), size);
+#else
+  NS_FATAL_ERROR("The saf module was built without protobuf support");
+  return 0;
+#endif
+}
+
+bool SafCodec::DecodeProtobuf(const uint8_t* buffer, uint32_t size, SafHeader& message) {
+#ifdef SAF_HAVE_PROTOBUF
+  // the message is read field by field straight from the buffer instead of
+  // being parsed into a saf::packets::Message, so nothing is allocated or copied
+  CodedInputStream input(buffer, size);
+  message.Clear();
+
+  bool hasPayload = false;
+  uint32_t tag;
+  while ((tag = input.ReadTag()) != 0) {
+    int field = WireFormatLite::GetTagFieldNumber(tag);
+    WireFormatLite::WireType type = WireFormatLite::GetTagWireType(tag);
+
+    if (type == WireFormatLite::WIRETYPE_LENGTH_DELIMITED &&
+        (field == saf::packets::Message::kRequestFieldNumber ||
+         field == saf::packets::Message::kResponseFieldNumber)) {
+      message.SetResponse(field == saf::packets::Message::kResponseFieldNumber);
+      if (!ReadPayload(input, message)) return false;
+      hasPayload = true;
+      continue;
+    }
+
+    uint64_t value;
+    if (type != WireFormatLite::WIRETYPE_VARINT) {
+      if (!WireFormatLite::SkipField(&input, tag)) return false;
+      continue;
+    }
+    if (!input.ReadVarint64(&value)) return false;
+
+    switch (field) {
+      case saf::packets::Message::kIdFieldNumber:
+        message.SetId(value);
+        break;
+      case saf::packets::Message::kResponseToFieldNumber:
+        message.SetResponseTo(value);
+        break;
+      case saf::packets::Message::kOriginalSentAtFieldNumber:
+        message.SetOriginalSentAt(value);
+        break;
+      case saf::packets::Message::kTimestampFieldNumber:
+        message.SetTimestamp(value);
+        break;
+      default:
+        break;
+    }
+  }
+
+  // ping messages are valid protobuf but are not handled by the application
+  return input.ConsumedEntireMessage() && hasPayload;
+#else
+  NS_FATAL_ERROR("The saf module was built without protobuf support");
+  return false;
+#endif
+}
+
+}  // namespace ns3
@@ -0,0 +1,84 @@
+#ifndef SAF_CODEC_H
+#define SAF_CODEC_H
+
+#include <stdint.h>
+#include <vector>  // std::vector
+
+#include "ns3/packet.h"
+#include "ns3/ptr.h"
+
+#include "saf-header.h"
+
+namespace google {
+namespace protobuf {
+class Arena;
+}  // namespace protobuf
+}  // namespace google
+
+namespace saf {
+namespace packets {
+class Message;
+}  // namespace packets
+}  // namespace saf
+
+namespace ns3 {
+
+/**
+ * \brief Converts SAF messages to and from packets.
+ *
+ * Messages are always handled as a SafHeader by the application, the codec
+ * takes care of putting them on the wire either as a protobuf encoded
+ * saf::packets::Message or as the fixed layout SafHeader itself. All of the
+ * buffers and protobuf messages are reused between packets so the steady
+ * state does not allocate anything beyond the packets themselves.
+ */
+class SafCodec {
+ public:
+  enum WireFormat { PROTOBUF, HEADER };
+
+  SafCodec();
+  ~SafCodec();
+
+  // the codec owns its arena, so it is neither copied nor assigned
+  SafCodec(const SafCodec&) = delete;
+  SafCodec& operator=(const SafCodec&) = delete;
+
+  // the format to use when the module is built without protobuf support is HEADER
+  static WireFormat GetDefaultWireFormat();
+
+  static bool IsSupported(WireFormat format);
+
+  void SetWireFormat(WireFormat format);
+  WireFormat GetWireFormat() const;
+
+  // size the scratch buffers for messages carrying data items of dataSize bytes
+  void Reserve(uint32_t dataSize);
+
+  Ptr<Packet> Encode(const SafHeader& message);
+
+  // returns false if the packet is not a valid request or response
+  bool Decode(Ptr<const Packet> packet, SafHeader& message);
+
+  // the number of bytes copied out of the last decoded packet
+  uint32_t GetCopiedBytes() const;
+
+ private:
+  Ptr<Packet> EncodeProtobuf(const SafHeader& message);
+
+  bool DecodeProtobuf(const uint8_t* buffer, uint32_t size, SafHeader& message);
+
+  WireFormat m_format;
+  uint32_t m_copied;
+
+  std::vector<uint8_t> m_rx_buffer;  // reused for every received packet
+  std::vector<uint8_t> m_tx_buffer;  // reused for every sent packet
+
+  // owns the reused messages below
+  google::protobuf::Arena* m_arena;
+  saf::packets::Message* m_tx_request;
+  saf::packets::Message* m_tx_response;
+};
+
+}  // namespace ns3
+
+#endif /* SAF_CODEC_H */
@@ -0,0 +1,213 @@
+
+#include "saf-header.h"
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED(SafHeader);
+
+const uint32_t SafHeader::BASE_SIZE;
+const uint32_t SafHeader::PREFIX_SIZE;
+
+SafHeader::SafHeader() { Clear(); }
+
+SafHeader::~SafHeader() {}
+
+TypeId SafHeader::GetTypeId(void) {
+  static TypeId tid = TypeId("ns3::SafHeader")
+                          .SetParent<Header>()
+                          .SetGroupName("Applications")
+                          .AddConstructor<SafHeader>();
+  return tid;
+}
+
+TypeId SafHeader::GetInstanceTypeId(void) const { return GetTypeId(); }
+
+void SafHeader::Print(std::ostream& os) const {
+  os << "id=" << m_id << " response_to=" << m_response_to
+     << " original_sent_at=" << m_original_sent_at << " timestamp=" << m_timestamp
+     << " data_id=" << m_data_id << " flags=" << (uint32_t)m_flags
+     << " data_size=" << m_data_size << " hops=" << (uint32_t)m_hops << "/"
+     << (uint32_t)m_hop_limit << " items=" << m_items.size();
+}
+
+uint32_t SafHeader::GetSerializedSize(void) const {
+  uint32_t size = IsMultiHop() ? BASE_SIZE + 2 : BASE_SIZE;
+  if (!IsBatch()) {
+    return size;
+  }
+  return size + 2 + m_items.size() * (IsResponse() ? 8 : 2);
+}
+
+void SafHeader::Serialize(Buffer::Iterator start) const {
+  Buffer::Iterator i = start;
+  i.WriteHtonU32(m_id);
+  i.WriteHtonU32(m_response_to);
+  i.WriteHtonU32(m_original_sent_at);
+  i.WriteHtonU32(m_timestamp);
+  i.WriteHtonU16(m_data_id);
+  i.WriteU8(m_flags);
+  i.WriteHtonU32(m_data_size);
+
+  if (IsMultiHop()) {
+    i.WriteU8(m_hops);
+    i.WriteU8(m_hop_limit);
+  }
+
+  if (!IsBatch()) {
+    return;
+  }
+
+  i.WriteHtonU16(m_items.size());
+  for (std::vector<Item>::const_iterator it = m_items.begin(); it != m_items.end(); ++it) {
+    i.WriteHtonU16(it->dataID);
+    if (IsResponse()) {
+      i.WriteHtonU16(it->offset);
+      i.WriteHtonU32(it->size);
+    }
+  }
+}
+
+uint32_t SafHeader::Deserialize(Buffer::Iterator start) {
+  Buffer::Iterator i = start;
+  m_id = i.ReadNtohU32();
+  m_response_to = i.ReadNtohU32();
+  m_original_sent_at = i.ReadNtohU32();
+  m_timestamp = i.ReadNtohU32();
+  m_data_id = i.ReadNtohU16();
+  m_flags = i.ReadU8();
+  m_data_size = i.ReadNtohU32();
+  m_hops = 0;
+  m_hop_limit = 0;
+  m_items.clear();
+
+  if (IsMultiHop()) {
+    m_hops = i.ReadU8();
+    m_hop_limit = i.ReadU8();
+  }
+
+  if (IsBatch()) {
+    uint16_t count = i.ReadNtohU16();
+    m_items.resize(count);
+    for (uint16_t n = 0; n < count; n++) {
+      m_items[n].dataID = i.ReadNtohU16();
+      m_items[n].offset = n;
+      m_items[n].size = 0;
+      if (IsResponse()) {
+        m_items[n].offset = i.ReadNtohU16();
+        m_items[n].size = i.ReadNtohU32();
+      }
+    }
+  }
+  return GetSerializedSize();
+}
+
+uint32_t SafHeader::PeekSerializedSize(const uint8_t* bytes, uint32_t length) {
+  if (length < BASE_SIZE) {
+    return 0;
+  }
+
+  // the flags follow the ID, the three timestamps and the data ID
+  uint8_t flags = bytes[18];
+  uint32_t size = (flags & MULTI_HOP) ? BASE_SIZE + 2 : BASE_SIZE;
+  if (!(flags & BATCH)) {
+    return size;
+  }
+
+  if (length < size + 2) {
+    return 0;
+  }
+  uint16_t count = (bytes[size] << 8) | bytes[size + 1];
+  return size + 2 + count * ((flags & RESPONSE) ? 8 : 2);
+}
+
+void SafHeader::Clear() {
+  m_id = 0;
+  m_response_to = 0;
+  m_original_sent_at = 0;
+  m_timestamp = 0;
+  m_data_id = 0;
+  m_flags = 0;
+  m_data_size = 0;
+  m_hops = 0;
+  m_hop_limit = 0;
+  m_items.clear();
+}
+
+void SafHeader::SetId(uint32_t id) { m_id = id; }
+
+uint32_t SafHeader::GetId() const { return m_id; }
+
+void SafHeader::SetResponseTo(uint32_t id) { m_response_to = id; }
+
+uint32_t SafHeader::GetResponseTo() const { return m_response_to; }
+
+void SafHeader::SetOriginalSentAt(uint32_t ms) { m_original_sent_at = ms; }
+
+uint32_t SafHeader::GetOriginalSentAt() const { return m_original_sent_at; }
+
+void SafHeader::SetTimestamp(uint32_t ms) { m_timestamp = ms; }
+
+uint32_t SafHeader::GetTimestamp() const { return m_timestamp; }
+
+void SafHeader::SetDataID(uint16_t dataID) { m_data_id = dataID; }
+
+uint16_t SafHeader::GetDataID() const { return m_data_id; }
+
+void SafHeader::SetDataSize(uint32_t size) { m_data_size = size; }
+
+uint32_t SafHeader::GetDataSize() const { return m_data_size; }
+
+void SafHeader::SetResponse(bool response) {
+  m_flags = response ? (m_flags | RESPONSE) : (m_flags & ~RESPONSE);
+}
+
+bool SafHeader::IsResponse() const { return m_flags & RESPONSE; }
+
+void SafHeader::SetReplication(bool replication) {
+  m_flags = replication ? (m_flags | REPLICATION) : (m_flags & ~REPLICATION);
+}
+
+bool SafHeader::IsReplication() const { return m_flags & REPLICATION; }
+
+bool SafHeader::IsBatch() const { return m_flags & BATCH; }
+
+void SafHeader::SetHopLimit(uint8_t limit) {
+  m_hop_limit = limit;
+  m_flags = limit != 0 ? (m_flags | MULTI_HOP) : (m_flags & ~MULTI_HOP);
+}
+
+uint8_t SafHeader::GetHopLimit() const { return m_hop_limit; }
+
+bool SafHeader::IsMultiHop() const { return m_flags & MULTI_HOP; }
+
+void SafHeader::SetHops(uint8_t hops) { m_hops = hops; }
+
+uint8_t SafHeader::GetHops() const { return m_hops; }
+
+void SafHeader::AddItem(uint16_t dataID, uint16_t offset, uint32_t size) {
+  m_flags |= BATCH;
+
+  Item item;
+  item.dataID = dataID;
+  item.offset = offset;
+  item.size = size;
+  m_items.push_back(item);
+  m_data_size += size;
+}
+
+uint16_t SafHeader::GetItemCount() const { return m_items.size(); }
+
+const SafHeader::Item& SafHeader::GetItem(uint16_t i) const { return m_items[i]; }
+
+bool SafHeader::RemoveItem(uint16_t dataID) {
+  for (std::vector<Item>::iterator it = m_items.begin(); it != m_items.end(); ++it) {
+    if (it->dataID == dataID) {
+      m_data_size -= it->size;
+      m_items.erase(it);
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace ns3
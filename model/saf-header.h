@@ -0,0 +1,120 @@
+#ifndef SAF_HEADER_H
+#define SAF_HEADER_H
+
+#include <stdint.h>
+#include <ostream>
+#include <vector>
+
+#include "ns3/buffer.h"
+#include "ns3/header.h"
+
+namespace ns3 {
+
+/**
+ * \brief Fixed layout wire format for SAF requests and responses.
+ *
+ * This carries the same fields as saf::packets::Message but with a fixed
+ * 23 byte layout, so it can be read and written without any protobuf
+ * encoding. For responses the data item itself follows the header as the
+ * packet payload. Timestamps are in milliseconds since the start of the
+ * simulation.
+ *
+ * A batched message carries a list of items after the fixed fields, for
+ * requests only the data ID of each item and for responses also the offset
+ * of the item in the request and its size. Item i of a batched request uses
+ * the message ID plus i as its request ID.
+ *
+ * Messages that are forwarded by the application carry the number of hops
+ * they travelled and their hop limit between the fixed fields and the items.
+ */
+class SafHeader : public Header {
+ public:
+  enum Flags { RESPONSE = 1 << 0, REPLICATION = 1 << 1, BATCH = 1 << 2, MULTI_HOP = 1 << 3 };
+
+  static const uint32_t BASE_SIZE = 23;               // the fixed fields every header has
+  static const uint32_t PREFIX_SIZE = BASE_SIZE + 4;  // enough bytes to tell the full size
+
+  struct Item {
+    uint16_t dataID;
+    uint16_t offset;  // the position of the item in the batched request
+    uint32_t size;    // the number of data bytes, only set on responses
+  };
+
+  SafHeader();
+  virtual ~SafHeader();
+
+  static TypeId GetTypeId(void);
+  virtual TypeId GetInstanceTypeId(void) const;
+  virtual void Print(std::ostream& os) const;
+  virtual uint32_t GetSerializedSize(void) const;
+  virtual void Serialize(Buffer::Iterator start) const;
+  virtual uint32_t Deserialize(Buffer::Iterator start);
+
+  // the serialized size of the header the bytes start with, 0 if there are too few of them to tell
+  static uint32_t PeekSerializedSize(const uint8_t* bytes, uint32_t length);
+
+  // reset every field back to zero
+  void Clear();
+
+  void SetId(uint32_t id);
+  uint32_t GetId() const;
+
+  // the ID of the request this is a response to, 0 for requests
+  void SetResponseTo(uint32_t id);
+  uint32_t GetResponseTo() const;
+
+  // the timestamp of the request, only set on responses
+  void SetOriginalSentAt(uint32_t ms);
+  uint32_t GetOriginalSentAt() const;
+
+  void SetTimestamp(uint32_t ms);
+  uint32_t GetTimestamp() const;
+
+  void SetDataID(uint16_t dataID);
+  uint16_t GetDataID() const;
+
+  // the number of data bytes that follow the header, only set on responses
+  void SetDataSize(uint32_t size);
+  uint32_t GetDataSize() const;
+
+  void SetResponse(bool response);
+  bool IsResponse() const;
+
+  void SetReplication(bool replication);
+  bool IsReplication() const;
+
+  bool IsBatch() const;
+
+  // a hop limit other than 0 makes this a message that is forwarded by the application
+  void SetHopLimit(uint8_t limit);
+  uint8_t GetHopLimit() const;
+  bool IsMultiHop() const;
+
+  // the number of times the message was forwarded before it was sent
+  void SetHops(uint8_t hops);
+  uint8_t GetHops() const;
+
+  // makes this a batched message, for responses the size is added to the data size
+  void AddItem(uint16_t dataID, uint16_t offset, uint32_t size);
+  uint16_t GetItemCount() const;
+  const Item& GetItem(uint16_t i) const;
+
+  // drops the item with the data ID, the others keep their offsets, returns false if there is none
+  bool RemoveItem(uint16_t dataID);
+
+ private:
+  uint32_t m_id;
+  uint32_t m_response_to;
+  uint32_t m_original_sent_at;
+  uint32_t m_timestamp;
+  uint16_t m_data_id;
+  uint8_t m_flags;
+  uint32_t m_data_size;
+  uint8_t m_hops;       // only used by multi-hop messages
+  uint8_t m_hop_limit;  // only used by multi-hop messages
+  std::vector<Item> m_items;  // only used by batched messages
+};
+
+}  // namespace ns3
+
+#endif /* SAF_HEADER_H */
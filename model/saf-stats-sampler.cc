@@ -0,0 +1,153 @@
+
+#include <stdio.h>  // snprintf
+
+#include "ns3/simulator.h"
+
+#include "saf-stats-sampler.h"
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED(SafStatsSampler);
+
+TypeId SafStatsSampler::GetTypeId(void) {
+  static TypeId tid = TypeId("ns3::SafStatsSampler")
+                          .SetParent<Object>()
+                          .SetGroupName("Applications")
+                          .AddConstructor<SafStatsSampler>()
+                          .AddAttribute(
+                              "Interval",
+                              "The simulation time between two rows",
+                              TimeValue(Seconds(256)),
+                              MakeTimeAccessor(&SafStatsSampler::m_interval),
+                              MakeTimeChecker(TimeStep(1)));
+  return tid;
+}
+
+SafStatsSampler::SafStatsSampler() {
+  m_counts.assign(SafStatsSink::NUM_COUNTERS, 0);
+  m_delay_counts.assign(SafStatsSink::NUM_DELAYS, 0);
+  m_delay_totals.assign(SafStatsSink::NUM_DELAYS, Time());
+}
+
+SafStatsSampler::~SafStatsSampler() {}
+
+void SafStatsSampler::DoDispose(void) {
+  Simulator::Cancel(m_event);
+  if (m_out.is_open()) {
+    m_out.close();
+  }
+  m_sink = 0;
+  Object::DoDispose();
+}
+
+Time SafStatsSampler::GetInterval() const { return m_interval; }
+
+bool SafStatsSampler::Start(Ptr<SafCounterSink> sink, const std::string& path) {
+  m_out.open(path.c_str(), std::ios::out | std::ios::trunc);
+  if (!m_out) {
+    return false;
+  }
+
+  m_sink = sink;
+  m_last_sample = Simulator::Now();
+  for (uint32_t i = 0; i < SafStatsSink::NUM_COUNTERS; i++) {
+    m_counts[i] = sink->GetTotal((SafStatsSink::Counter)i);
+  }
+  for (uint32_t i = 0; i < SafStatsSink::NUM_DELAYS; i++) {
+    Ptr<TimeHistogramCalculator> delays = sink->GetDelayCalculator((SafStatsSink::Delay)i);
+    m_delay_counts[i] = delays->GetCount();
+    m_delay_totals[i] = delays->GetTotal();
+  }
+
+  m_row = "time";
+  for (uint32_t i = 0; i < SafStatsSink::NUM_COUNTERS; i++) {
+    m_row += ",";
+    m_row += SafStatsSink::GetCounterName((SafStatsSink::Counter)i);
+  }
+  for (uint32_t i = 0; i < SafStatsSink::NUM_DELAYS; i++) {
+    const char* name = SafStatsSink::GetDelayName((SafStatsSink::Delay)i);
+    m_row += ",";
+    m_row += name;
+    m_row += "-count,";
+    m_row += name;
+    m_row += "-mean-ms";
+  }
+  m_row += ",accessibility\n";
+  m_out.write(m_row.data(), m_row.size());
+
+  m_event = Simulator::Schedule(m_interval, &SafStatsSampler::Sample, this);
+  return true;
+}
+
+void SafStatsSampler::Stop() {
+  Simulator::Cancel(m_event);
+  if (m_sink != 0 && Simulator::Now() > m_last_sample) {
+    WriteRow();
+  }
+  if (m_out.is_open()) {
+    m_out.close();
+  }
+  m_sink = 0;
+}
+
+void SafStatsSampler::Sample() {
+  WriteRow();
+  m_event = Simulator::Schedule(m_interval, &SafStatsSampler::Sample, this);
+}
+
+void SafStatsSampler::WriteRow() {
+  m_sink->Flush();
+  m_last_sample = Simulator::Now();
+
+  char field[32];
+  snprintf(field, sizeof(field), "%.3f", Simulator::Now().GetSeconds());
+  m_row = field;
+
+  uint64_t counted[SafStatsSink::NUM_COUNTERS];
+  for (uint32_t i = 0; i < SafStatsSink::NUM_COUNTERS; i++) {
+    uint64_t total = m_sink->GetTotal((SafStatsSink::Counter)i);
+    counted[i] = total - m_counts[i];
+    m_counts[i] = total;
+
+    snprintf(field, sizeof(field), ",%llu", (unsigned long long)counted[i]);
+    m_row += field;
+  }
+
+  uint64_t delays[SafStatsSink::NUM_DELAYS];
+  for (uint32_t i = 0; i < SafStatsSink::NUM_DELAYS; i++) {
+    Ptr<TimeHistogramCalculator> calculator =
+        m_sink->GetDelayCalculator((SafStatsSink::Delay)i);
+    delays[i] = calculator->GetCount() - m_delay_counts[i];
+    Time total = calculator->GetTotal() - m_delay_totals[i];
+    m_delay_counts[i] = calculator->GetCount();
+    m_delay_totals[i] = calculator->GetTotal();
+
+    if (delays[i] > 0) {
+      snprintf(
+          field,
+          sizeof(field),
+          ",%llu,%.3f",
+          (unsigned long long)delays[i],
+          total.GetSeconds() * 1000 / delays[i]);
+    } else {
+      snprintf(field, sizeof(field), ",0,");
+    }
+    m_row += field;
+  }
+
+  // lookups that were answered locally or before they timed out, attached ones included
+  uint64_t lookups = counted[SafStatsSink::CACHE_HIT] + counted[SafStatsSink::LOOKUP_SENT] +
+                     counted[SafStatsSink::LOOKUP_COALESCED];
+  uint64_t answered = counted[SafStatsSink::CACHE_HIT] + delays[SafStatsSink::LOOKUP_ONTIME] +
+                      delays[SafStatsSink::LOOKUP_COALESCED_ONTIME];
+  if (lookups > 0) {
+    snprintf(field, sizeof(field), ",%.4f\n", (double)answered / lookups);
+  } else {
+    snprintf(field, sizeof(field), ",\n");
+  }
+  m_row += field;
+
+  m_out.write(m_row.data(), m_row.size());
+}
+
+}  // namespace ns3
@@ -0,0 +1,78 @@
+#ifndef SAF_STATS_SAMPLER_H
+#define SAF_STATS_SAMPLER_H
+
+#include <stdint.h>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+
+#include "saf-stats-sink.h"
+
+namespace ns3 {
+
+/**
+ * \brief Appends a row of the SafCounterSink statistics to a CSV file every interval.
+ *
+ * Each row holds the simulation time in seconds, what every counter counted
+ * during the interval, the number and mean in milliseconds of every kind of
+ * delay during the interval, and the data accessibility of the interval:
+ * the lookups answered locally or in time over all of the lookups.
+ *
+ * Only the totals at the last sample are kept, so the memory used does not
+ * grow with the length of the run. A row is built in a reused buffer and
+ * written in one go into the buffered file stream, which is only flushed
+ * when the sampler is stopped or disposed, so sampling does not cost a
+ * system call per row.
+ */
+class SafStatsSampler : public Object {
+ public:
+  static TypeId GetTypeId(void);
+
+  SafStatsSampler();
+  virtual ~SafStatsSampler();
+
+  /**
+   * Start sampling the sink, the first row is written one interval from now.
+   *
+   * \param sink The statistics to sample, they are also flushed at every sample.
+   * \param path The CSV file to write, it is replaced if it exists.
+   * \returns false if the file could not be opened.
+   */
+  bool Start(Ptr<SafCounterSink> sink, const std::string& path);
+
+  // write the row of the interval that is still open, if any time passed, flush and stop sampling
+  void Stop();
+
+  Time GetInterval() const;
+
+ protected:
+  virtual void DoDispose(void);
+
+ private:
+  void Sample();
+
+  // append the row of everything counted since the last sample
+  void WriteRow();
+
+  Time m_interval;
+  EventId m_event;
+  Time m_last_sample;
+
+  Ptr<SafCounterSink> m_sink;
+  std::ofstream m_out;
+  std::string m_row;  // reused for every row
+
+  // the totals at the last sample
+  std::vector<uint64_t> m_counts;
+  std::vector<uint64_t> m_delay_counts;
+  std::vector<Time> m_delay_totals;
+};
+
+}  // namespace ns3
+
+#endif /* SAF_STATS_SAMPLER_H */
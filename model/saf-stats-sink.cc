@@ -0,0 +1,205 @@
+
+#include <algorithm>
+#include <limits>
+
+#include "ns3/assert.h"
+
+#include "logging.h"
+
+#include "saf-stats-sink.h"
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED(SafStatsSink);
+NS_OBJECT_ENSURE_REGISTERED(SafCounterSink);
+
+// in the order of the enums, these are the keys the example has always used
+static const char* const COUNTER_NAMES[SafStatsSink::NUM_COUNTERS] = {
+    "cache-hit",
+    "lookup-sent",
+    "lookup-rcv",
+    "lookup-rsp-sent",
+    "lookup-timeout",
+    "lookup-coalesced",
+    "realloc-sent",
+    "realloc-rcv",
+    "realloc-rsp-sent",
+    "realloc-timeout",
+    "rsp-suppressed",
+    "request-forwarded",
+    "overheard-rcv",
+    "overheard-saved",
+    "overheard-hit"};
+
+static const char* const DELAY_NAMES[SafStatsSink::NUM_DELAYS] = {
+    "lookup-ontime-delay",
+    "lookup-late-delay",
+    "lookup-coalesced-ontime-delay",
+    "realloc-ontime-delay",
+    "realloc-late-delay"};
+
+// the item matrix kind each counter and delay is counted as, -1 if it is not
+static const int8_t COUNTER_KINDS[SafStatsSink::NUM_COUNTERS] = {
+    ItemCounterMatrix::HIT,      // CACHE_HIT
+    ItemCounterMatrix::MISS,     // LOOKUP_SENT
+    -1,                          // LOOKUP_RCV
+    -1,                          // LOOKUP_RSP_SENT
+    ItemCounterMatrix::TIMEOUT,  // LOOKUP_TIMEOUT
+    ItemCounterMatrix::MISS,     // LOOKUP_COALESCED
+    -1,                          // REALLOC_SENT
+    -1,                          // REALLOC_RCV
+    -1,                          // REALLOC_RSP_SENT
+    -1,                          // REALLOC_TIMEOUT
+    -1,                          // RSP_SUPPRESSED
+    -1,                          // REQUEST_FORWARDED
+    -1,                          // OVERHEARD_RCV
+    -1,                          // OVERHEARD_SAVED
+    -1};                         // OVERHEARD_HIT, already counted as a CACHE_HIT
+
+static const int8_t DELAY_KINDS[SafStatsSink::NUM_DELAYS] = {
+    -1,                       // LOOKUP_ONTIME
+    ItemCounterMatrix::LATE,  // LOOKUP_LATE
+    -1,                       // LOOKUP_COALESCED_ONTIME
+    -1,                       // REALLOC_ONTIME
+    -1};                      // REALLOC_LATE
+
+TypeId SafStatsSink::GetTypeId(void) {
+  static TypeId tid = TypeId("ns3::SafStatsSink").SetParent<Object>().SetGroupName("Applications");
+  return tid;
+}
+
+SafStatsSink::SafStatsSink() {}
+
+SafStatsSink::~SafStatsSink() {}
+
+const char* SafStatsSink::GetCounterName(Counter counter) {
+  NS_ASSERT(counter < NUM_COUNTERS);
+  return COUNTER_NAMES[counter];
+}
+
+const char* SafStatsSink::GetDelayName(Delay delay) {
+  NS_ASSERT(delay < NUM_DELAYS);
+  return DELAY_NAMES[delay];
+}
+
+TypeId SafCounterSink::GetTypeId(void) {
+  static TypeId tid = TypeId("ns3::SafCounterSink")
+                          .SetParent<SafStatsSink>()
+                          .SetGroupName("Applications")
+                          .AddConstructor<SafCounterSink>();
+  return tid;
+}
+
+SafCounterSink::SafCounterSink() {
+  m_nodes = 0;
+  m_item_matrix_enabled = false;
+  m_flushed.assign(NUM_COUNTERS, 0);
+
+  for (uint32_t i = 0; i < NUM_COUNTERS; i++) {
+    Ptr<CounterCalculator<>> calculator = CreateObject<CounterCalculator<>>();
+    calculator->SetKey(COUNTER_NAMES[i]);
+    m_counters.push_back(calculator);
+  }
+
+  for (uint32_t i = 0; i < NUM_DELAYS; i++) {
+    Ptr<TimeHistogramCalculator> calculator = CreateObject<TimeHistogramCalculator>();
+    calculator->SetKey(DELAY_NAMES[i]);
+    m_delays.push_back(calculator);
+  }
+}
+
+SafCounterSink::~SafCounterSink() {}
+
+void SafCounterSink::DoDispose(void) {
+  m_counters.clear();
+  m_delays.clear();
+  SafStatsSink::DoDispose();
+}
+
+void SafCounterSink::Reserve(uint32_t numNodes) {
+  if (numNodes > m_nodes) {
+    m_counts.resize(numNodes * NUM_COUNTERS, 0);
+    m_nodes = numNodes;
+  }
+}
+
+void SafCounterSink::AddCalculators(DataCollector& collector) {
+  for (uint32_t i = 0; i < NUM_COUNTERS; i++) {
+    collector.AddDataCalculator(m_counters[i]);
+  }
+  for (uint32_t i = 0; i < NUM_DELAYS; i++) {
+    collector.AddDataCalculator(m_delays[i]);
+  }
+}
+
+void SafCounterSink::Flush() {
+  // the calculators only count up, so they are given what was counted since the last flush
+  const uint64_t limit = std::numeric_limits<uint32_t>::max();
+  for (uint32_t i = 0; i < NUM_COUNTERS; i++) {
+    // CounterCalculator only has 32 bits, DataOutputCallback can not write a 64 bit count, so
+    // the output stops at the limit instead of wrapping around
+    uint64_t total = GetTotal((Counter)i);
+    if (total > limit && m_flushed[i] < limit) {
+      NS_LOG_WARN("the " << COUNTER_NAMES[i] << " output stops at " << limit);
+    }
+    total = std::min(total, limit);
+
+    if (total > m_flushed[i]) {
+      m_counters[i]->Update((uint32_t)(total - m_flushed[i]));
+      m_flushed[i] = total;
+    }
+  }
+}
+
+void SafCounterSink::EnableItemMatrix(uint16_t totalItems) {
+  m_item_matrix.Init(m_nodes, totalItems);
+  m_item_matrix_enabled = true;
+}
+
+const ItemCounterMatrix& SafCounterSink::GetItemMatrix() const { return m_item_matrix; }
+
+void SafCounterSink::Count(Counter counter, uint16_t dataID, uint32_t nodeID) {
+  if (nodeID >= m_nodes) {
+    Reserve(nodeID + 1);
+  }
+  m_counts[nodeID * NUM_COUNTERS + counter]++;
+
+  if (m_item_matrix_enabled && COUNTER_KINDS[counter] >= 0) {
+    m_item_matrix.Increment(nodeID, dataID, (ItemCounterMatrix::Kind)COUNTER_KINDS[counter]);
+  }
+}
+
+void SafCounterSink::Record(Delay delay, uint16_t dataID, uint32_t nodeID, Time value) {
+  m_delays[delay]->Update(value);
+
+  if (m_item_matrix_enabled && DELAY_KINDS[delay] >= 0) {
+    m_item_matrix.Increment(nodeID, dataID, (ItemCounterMatrix::Kind)DELAY_KINDS[delay]);
+  }
+}
+
+uint32_t SafCounterSink::GetNNodes() const { return m_nodes; }
+
+uint64_t SafCounterSink::GetCount(uint32_t nodeID, Counter counter) const {
+  if (nodeID >= m_nodes) {
+    return 0;
+  }
+  return m_counts[nodeID * NUM_COUNTERS + counter];
+}
+
+uint64_t SafCounterSink::GetTotal(Counter counter) const {
+  uint64_t total = 0;
+  for (uint32_t node = 0; node < m_nodes; node++) {
+    total += m_counts[node * NUM_COUNTERS + counter];
+  }
+  return total;
+}
+
+Ptr<CounterCalculator<>> SafCounterSink::GetCounterCalculator(Counter counter) const {
+  return m_counters[counter];
+}
+
+Ptr<TimeHistogramCalculator> SafCounterSink::GetDelayCalculator(Delay delay) const {
+  return m_delays[delay];
+}
+
+}  // namespace ns3
@@ -0,0 +1,128 @@
+#ifndef SAF_STATS_SINK_H
+#define SAF_STATS_SINK_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "ns3/basic-data-calculators.h"
+#include "ns3/data-collector.h"
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+
+#include "item-counter-matrix.h"
+#include "time-histogram-calculator.h"
+
+namespace ns3 {
+
+/**
+ * \brief Receives the statistics events of every SafApplication.
+ *
+ * One sink is usually shared by all of the applications through their
+ * StatsSink attribute. Every event names the data item and the node it
+ * happened at.
+ */
+class SafStatsSink : public Object {
+ public:
+  enum Counter {
+    CACHE_HIT,          // a lookup found the item in the local store
+    LOOKUP_SENT,        // a lookup request was sent
+    LOOKUP_RCV,         // a lookup request was received
+    LOOKUP_RSP_SENT,    // a lookup was answered
+    LOOKUP_TIMEOUT,     // a lookup got no response in time
+    LOOKUP_COALESCED,   // a lookup attached to a pending request for the same item
+    REALLOC_SENT,       // a replica was requested
+    REALLOC_RCV,        // a replica request was received
+    REALLOC_RSP_SENT,   // a replica request was answered
+    REALLOC_TIMEOUT,    // a replica request got no response in time
+    RSP_SUPPRESSED,     // a scheduled response was cancelled since another node answered
+    REQUEST_FORWARDED,  // a multi-hop request was forwarded
+    OVERHEARD_RCV,      // an item in a response to another node was seen
+    OVERHEARD_SAVED,    // an overheard item was admitted as a replica
+    OVERHEARD_HIT,      // a cache hit on an item admitted from an overheard response
+    NUM_COUNTERS
+  };
+
+  enum Delay {
+    LOOKUP_ONTIME,            // a lookup was answered before it timed out
+    LOOKUP_LATE,              // a lookup was answered after it timed out
+    LOOKUP_COALESCED_ONTIME,  // the request an attached lookup waited on was answered
+    REALLOC_ONTIME,           // a replica request was answered before it timed out
+    REALLOC_LATE,             // a replica request was answered after it timed out
+    NUM_DELAYS
+  };
+
+  static TypeId GetTypeId(void);
+
+  SafStatsSink();
+  virtual ~SafStatsSink();
+
+  // the key the statistic is output under
+  static const char* GetCounterName(Counter counter);
+  static const char* GetDelayName(Delay delay);
+
+  virtual void Count(Counter counter, uint16_t dataID, uint32_t nodeID) = 0;
+  virtual void Record(Delay delay, uint16_t dataID, uint32_t nodeID, Time value) = 0;
+};
+
+/**
+ * \brief Counts the events of every node in a flat array.
+ *
+ * An event only increments one slot of the array, the counters reach the
+ * DataCollector when Flush is called, at the end of the run or at sampling
+ * points, each as a CounterCalculator keyed by the name of the counter.
+ * The counts are 64 bit, but the calculators stop at the 32 bit limit.
+ * Delays go straight into a TimeHistogramCalculator per kind, which only
+ * increments a bucket as well.
+ *
+ * Once the item matrix is enabled the lookup hits, misses, timeouts and late
+ * responses are also counted per node and data item.
+ */
+class SafCounterSink : public SafStatsSink {
+ public:
+  static TypeId GetTypeId(void);
+
+  SafCounterSink();
+  virtual ~SafCounterSink();
+
+  // size the array so that nodes with an ID below numNodes never grow it
+  void Reserve(uint32_t numNodes);
+
+  // add every calculator to the collector, call once before the calculators are output
+  void AddCalculators(DataCollector& collector);
+
+  // bring the calculators up to date with the counters
+  void Flush();
+
+  // also count the lookup outcomes per node and item, for data IDs 1 to totalItems
+  void EnableItemMatrix(uint16_t totalItems);
+  const ItemCounterMatrix& GetItemMatrix() const;
+
+  virtual void Count(Counter counter, uint16_t dataID, uint32_t nodeID);
+  virtual void Record(Delay delay, uint16_t dataID, uint32_t nodeID, Time value);
+
+  uint32_t GetNNodes() const;
+  uint64_t GetCount(uint32_t nodeID, Counter counter) const;
+  uint64_t GetTotal(Counter counter) const;
+
+  Ptr<CounterCalculator<>> GetCounterCalculator(Counter counter) const;
+  Ptr<TimeHistogramCalculator> GetDelayCalculator(Delay delay) const;
+
+ protected:
+  virtual void DoDispose(void);
+
+ private:
+  std::vector<uint64_t> m_counts;  // node ID * NUM_COUNTERS + counter -> count
+  uint32_t m_nodes;
+
+  std::vector<Ptr<CounterCalculator<>>> m_counters;
+  std::vector<uint64_t> m_flushed;  // the totals the counter calculators already have
+  std::vector<Ptr<TimeHistogramCalculator>> m_delays;
+
+  bool m_item_matrix_enabled;
+  ItemCounterMatrix m_item_matrix;
+};
+
+}  // namespace ns3
+
+#endif /* SAF_STATS_SINK_H */
@@ -1,9 +1,13 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 
-#include <math.h>     // std::pow
-#include <algorithm>  // std::sort
+#include <algorithm>  // std::min
+#include <chrono>     // std::chrono::steady_clock
+#include <math.h>     // log
 
+#include "ns3/abort.h"
+#include "ns3/boolean.h"
 #include "ns3/double.h"
+#include "ns3/enum.h"
 #include "ns3/inet-socket-address.h"
 #include "ns3/inet6-socket-address.h"
 #include "ns3/ipv4-address.h"
@@ -12,6 +16,7 @@
 //#include "ns3/log.h"
 #include "ns3/nstime.h"
 #include "ns3/packet.h"
+#include "ns3/pointer.h"
 #include "ns3/simulator.h"
 #include "ns3/socket-factory.h"
 #include "ns3/socket.h"
@@ -23,13 +28,19 @@
 
 #include "saf.h"
 
-#include "proto/message.pb.h"
-
 namespace ns3 {
 
 NS_OBJECT_ENSURE_REGISTERED(SafApplication);
 
-bool AccessFrequencyComparator(std::vector<uint16_t> i, std::vector<uint16_t> j);
+// the IP TTL of broadcast requests
+static const uint8_t REQUEST_TTL = 2;
+
+// the number of multi-hop requests a node remembers, enough for every copy of a
+// flood to arrive long after the request was first seen
+static const uint32_t SEEN_REQUESTS = 1024;
+
+// the NodeIndex that stands for the ID of the node
+static const uint32_t NODE_ID_INDEX = 0xffffffff;
 
 TypeId SafApplication::GetTypeId(void) {
   static TypeId tid = TypeId("ns3::SafApplication")
@@ -48,6 +59,13 @@ TypeId SafApplication::GetTypeId(void) {
                               TimeValue(10.0_sec),
                               MakeTimeAccessor(&SafApplication::m_request_timeout),
                               MakeTimeChecker(0.5_sec))
+                          .AddAttribute(
+                              "TimeoutResolution",
+                              "Request timeouts are rounded up to a multiple of this so that "
+                              "they expire together, zero keeps them exact.",
+                              TimeValue(Seconds(0)),
+                              MakeTimeAccessor(&SafApplication::m_timeout_resolution),
+                              MakeTimeChecker(Seconds(0)))
                           .AddAttribute(
                               "DataSize",
                               "The number of bytes in each data object.",
@@ -73,6 +91,14 @@ TypeId SafApplication::GetTypeId(void) {
                               UintegerValue(0),
                               MakeUintegerAccessor(&SafApplication::m_total_num_nodes),
                               MakeUintegerChecker<uint32_t>())
+                          .AddAttribute(
+                              "NodeIndex",
+                              "The position of the node among the NumNodes nodes, which picks "
+                              "its original data items and message IDs. Set by the helper, "
+                              "the node ID is used when left at its default.",
+                              UintegerValue(NODE_ID_INDEX),
+                              MakeUintegerAccessor(&SafApplication::m_node_index),
+                              MakeUintegerChecker<uint32_t>())
                           .AddAttribute(
                               "StorageSpace",
                               "The number of data items the node can hold",
@@ -92,104 +118,140 @@ TypeId SafApplication::GetTypeId(void) {
                               MakeDoubleAccessor(&SafApplication::m_standard_deviation),
                               MakeDoubleChecker<double>())
                           .AddAttribute(
-                              "cache_hit_CB",
-                              "a callback to be called when a data item is looked up "
-                              "but found in the local cache",
-                              CallbackValue(),
-                              MakeCallbackAccessor(&SafApplication::m_cache_hit_CB),
-                              MakeCallbackChecker())
+                              "CoalesceLookups",
+                              "Attach lookups of an item to the request for it that is still "
+                              "pending instead of sending another one",
+                              BooleanValue(true),
+                              MakeBooleanAccessor(&SafApplication::m_coalesce_lookups),
+                              MakeBooleanChecker())
+                          .AddAttribute(
+                              "LocationCacheSize",
+                              "The number of data items whose last known holder is kept, "
+                              "lookups of those items are sent to the holder instead of "
+                              "broadcast. 0 disables the cache.",
+                              UintegerValue(0),
+                              MakeUintegerAccessor(&SafApplication::m_location_cache_size),
+                              MakeUintegerChecker<uint16_t>())
                           .AddAttribute(
-                              "lookup_sent_CB",
-                              "a callback to be called when the application sends a "
-                              "lookup request",
-                              CallbackValue(),
-                              MakeCallbackAccessor(&SafApplication::m_lookup_sent_CB),
-                              MakeCallbackChecker())
+                              "LocationCacheLifetime",
+                              "How long a learned holder is used for before lookups are "
+                              "broadcast again",
+                              TimeValue(Seconds(60)),
+                              MakeTimeAccessor(&SafApplication::m_location_cache_lifetime),
+                              MakeTimeChecker())
                           .AddAttribute(
-                              "lookup_rcv_CB",
-                              "a callback to be called when a data item is requested "
-                              "from the nodes peer only "
-                              "application requests",
-                              CallbackValue(),
-                              MakeCallbackAccessor(&SafApplication::m_lookup_rcv_CB),
-                              MakeCallbackChecker())
+                              "MaxHops",
+                              "The number of hops a lookup travels at most. Above 1 peers that "
+                              "do not hold the item forward the lookup, which is first sent "
+                              "to 1 hop and then to twice as many hops after every timeout. "
+                              "Each ring waits its share of MaxHops of the RequestTimeout. "
+                              "1 only asks the direct neighbors.",
+                              UintegerValue(1),
+                              MakeUintegerAccessor(&SafApplication::m_max_hops),
+                              MakeUintegerChecker<uint8_t>(1))
                           .AddAttribute(
-                              "lookup_rsp_sent_CB",
-                              "a callback to be called when a data item being sent to a remote "
-                              "peer only for "
-                              "application lookups",
-                              CallbackValue(),
-                              MakeCallbackAccessor(&SafApplication::m_lookup_rsp_sent_CB),
-                              MakeCallbackChecker())
+                              "ResponseSuppression",
+                              "Responders wait a random backoff before broadcasting their "
+                              "response, and cancel it if they hear another response to the "
+                              "same request first",
+                              BooleanValue(false),
+                              MakeBooleanAccessor(&SafApplication::m_response_suppression),
+                              MakeBooleanChecker())
                           .AddAttribute(
-                              "lookup_timeout_CB",
-                              "a callback to be called when the application data lookup "
-                              "request times out",
-                              CallbackValue(),
-                              MakeCallbackAccessor(&SafApplication::m_lookup_timeout_CB),
-                              MakeCallbackChecker())
+                              "BroadcastResponses",
+                              "Responders broadcast their response right away instead of "
+                              "sending it to the requester, so every neighbor hears it",
+                              BooleanValue(false),
+                              MakeBooleanAccessor(&SafApplication::m_broadcast_responses),
+                              MakeBooleanChecker())
                           .AddAttribute(
-                              "realloc_timeout_CB",
-                              "a callback to be called when the reallocation data lookup "
-                              "request times out",
-                              CallbackValue(),
-                              MakeCallbackAccessor(&SafApplication::m_realloc_timeout_CB),
-                              MakeCallbackChecker())
+                              "CacheOverheard",
+                              "Items in responses to other nodes are admitted as replicas when "
+                              "they rank above a replica that is held, without ever taking the "
+                              "place of an allocated replica",
+                              BooleanValue(false),
+                              MakeBooleanAccessor(&SafApplication::m_cache_overheard),
+                              MakeBooleanChecker())
                           .AddAttribute(
-                              "realloc_sent_CB",
-                              "a callback to be called when the reallocation proccess sends a "
-                              "lookup request",
-                              CallbackValue(),
-                              MakeCallbackAccessor(&SafApplication::m_realloc_sent_CB),
-                              MakeCallbackChecker())
+                              "SuppressionBackoff",
+                              "The longest backoff of a responder one hop from the requester, "
+                              "each further hop adds this much again",
+                              TimeValue(MilliSeconds(10)),
+                              MakeTimeAccessor(&SafApplication::m_suppression_backoff),
+                              MakeTimeChecker(Seconds(0)))
                           .AddAttribute(
-                              "realloc_rcv_CB",
-                              "a callback to be called when a data item being "
-                              "requested by a remote peer only for "
-                              "reallocation lookups",
-                              CallbackValue(),
-                              MakeCallbackAccessor(&SafApplication::m_realloc_rcv_CB),
-                              MakeCallbackChecker())
+                              "BatchReplication",
+                              "Ask for every missing replica of a reallocation round in one "
+                              "request, responders answer with every item they hold in one reply",
+                              BooleanValue(false),
+                              MakeBooleanAccessor(&SafApplication::m_batch_replication),
+                              MakeBooleanChecker())
                           .AddAttribute(
-                              "realloc_rsp_sent_CB",
-                              "a callback to be called when a data item being sent to a remote "
-                              "peer only for "
-                              "reallocation lookups",
-                              CallbackValue(),
-                              MakeCallbackAccessor(&SafApplication::m_realloc_rsp_sent_CB),
-                              MakeCallbackChecker())
+                              "WireFormat",
+                              "The encoding of requests and responses on the wire",
+                              EnumValue(SafCodec::GetDefaultWireFormat()),
+                              MakeEnumAccessor(&SafApplication::m_wire_format),
+                              MakeEnumChecker(
+                                  SafCodec::PROTOBUF,
+                                  "Protobuf",
+                                  SafCodec::HEADER,
+                                  "Header"))
                           .AddAttribute(
-                              "lookup_ontime_CB",
-                              "a callback to be called when a data item requested by the "
-                              "application is received "
-                              "before the timeout event",
-                              CallbackValue(),
-                              MakeCallbackAccessor(&SafApplication::m_lookup_ontime_CB),
-                              MakeCallbackChecker())
+                              "Catalog",
+                              "The access frequencies of the data items, shared between nodes "
+                              "when they are the same for every node. Built by the application "
+                              "when not set.",
+                              PointerValue(),
+                              MakePointerAccessor(&SafApplication::m_catalog),
+                              MakePointerChecker<SafCatalog>())
                           .AddAttribute(
-                              "lookup_late_CB",
-                              "a callback to be called when a data item requested by "
-                              "the application is received "
-                              "after the timeout event",
-                              CallbackValue(),
-                              MakeCallbackAccessor(&SafApplication::m_lookup_late_CB),
-                              MakeCallbackChecker())
+                              "LookupEngine",
+                              "How the data lookups of the node are scheduled, PerItem keeps "
+                              "one event chain per data item while Aggregate drives all of "
+                              "them from a single event",
+                              EnumValue(SafApplication::PER_ITEM),
+                              MakeEnumAccessor(&SafApplication::m_lookup_engine),
+                              MakeEnumChecker(
+                                  SafApplication::PER_ITEM,
+                                  "PerItem",
+                                  SafApplication::AGGREGATE,
+                                  "Aggregate"))
                           .AddAttribute(
-                              "realloc_ontime_CB",
-                              "a callback to be called when a data item requested by the "
-                              "reallocation proccess is "
-                              "received before the timeout event",
-                              CallbackValue(),
-                              MakeCallbackAccessor(&SafApplication::m_realloc_ontime_CB),
-                              MakeCallbackChecker())
+                              "ReplicaAllocation",
+                              "How the replicas held by the node are chosen every "
+                              "reallocation period, Dafn and Dcg also look at the neighbors "
+                              "of the node",
+                              EnumValue(ReplicaAllocationPolicy::SAF),
+                              MakeEnumAccessor(&SafApplication::m_replica_allocation),
+                              MakeEnumChecker(
+                                  ReplicaAllocationPolicy::SAF,
+                                  "Saf",
+                                  ReplicaAllocationPolicy::DAFN,
+                                  "Dafn",
+                                  ReplicaAllocationPolicy::DCG,
+                                  "Dcg"))
                           .AddAttribute(
-                              "realloc_late_CB",
-                              "a callback to be called when a data item requested by the "
-                              "reallocation proccess is "
-                              "received after the timeout event",
-                              CallbackValue(),
-                              MakeCallbackAccessor(&SafApplication::m_realloc_late_CB),
-                              MakeCallbackChecker())
+                              "ReplicaAllocationPolicy",
+                              "The policy that allocates the replicas, shared between the "
+                              "nodes so Dafn and Dcg can see all of them. Built by the "
+                              "application when not set.",
+                              PointerValue(),
+                              MakePointerAccessor(&SafApplication::m_allocation_policy),
+                              MakePointerChecker<ReplicaAllocationPolicy>())
+                          .AddAttribute(
+                              "NeighborRange",
+                              "The distance in meters within which the replica allocation "
+                              "treats two nodes as neighbors",
+                              DoubleValue(250.0),
+                              MakeDoubleAccessor(&SafApplication::m_neighbor_range),
+                              MakeDoubleChecker<double>(0.0))
+                          .AddAttribute(
+                              "StatsSink",
+                              "Where the statistics events of the application go, usually "
+                              "shared by every application. No statistics are kept when unset.",
+                              PointerValue(),
+                              MakePointerAccessor(&SafApplication::m_stats),
+                              MakePointerChecker<SafStatsSink>())
                           .AddTraceSource(
                               "Tx",
                               "A new packet is created and is sent",
@@ -200,6 +262,16 @@ TypeId SafApplication::GetTypeId(void) {
                               "A packet has been received",
                               MakeTraceSourceAccessor(&SafApplication::m_rxTrace),
                               "ns3::Packet::TracedCallback")
+                          .AddTraceSource(
+                              "RxBytesCopied",
+                              "The number of payload bytes copied out of a received packet",
+                              MakeTraceSourceAccessor(&SafApplication::m_rxCopiedTrace),
+                              "ns3::SafApplication::CopiedBytesTracedCallback")
+                          .AddTraceSource(
+                              "OverheardTime",
+                              "The wall clock time spent caching an overheard item",
+                              MakeTraceSourceAccessor(&SafApplication::m_overheardTimeTrace),
+                              "ns3::SafApplication::OverheardTimeTracedCallback")
                           .AddTraceSource(
                               "TxWithAddresses",
                               "A new packet is created and is sent",
@@ -219,21 +291,13 @@ SafApplication::SafApplication() {
   m_socket_send = 0;
   m_socket_recv = 0;
   m_running = false;
+  m_allocation_member = 0;
 
-  m_cache_hit_CB = MakeNullCallback<void, uint16_t, uint32_t>();
-  m_lookup_sent_CB = MakeNullCallback<void, uint16_t, uint32_t>();
-  m_lookup_rcv_CB = MakeNullCallback<void, uint16_t, uint32_t>();
-  m_lookup_rsp_sent_CB = MakeNullCallback<void, uint16_t, uint32_t>();
-  m_lookup_timeout_CB = MakeNullCallback<void, uint32_t, uint32_t>();
-  m_realloc_timeout_CB = MakeNullCallback<void, uint32_t, uint32_t>();
-  m_realloc_sent_CB = MakeNullCallback<void, uint16_t, uint32_t>();
-  m_realloc_rcv_CB = MakeNullCallback<void, uint16_t, uint32_t>();
-  m_realloc_rsp_sent_CB = MakeNullCallback<void, uint16_t, uint32_t>();
+  m_timeouts.SetExpireCallback(MakeCallback(&SafApplication::RequestTimeout, this));
 
-  m_lookup_ontime_CB = MakeNullCallback<void, uint16_t, uint32_t, ns3::Time>();
-  m_lookup_late_CB = MakeNullCallback<void, uint16_t, uint32_t, ns3::Time>();
-  m_realloc_ontime_CB = MakeNullCallback<void, uint16_t, uint32_t, ns3::Time>();
-  m_realloc_late_CB = MakeNullCallback<void, uint16_t, uint32_t, ns3::Time>();
+  m_lookup_stream = CreateObject<UniformRandomVariable>();
+  m_backoff = CreateObject<UniformRandomVariable>();
+  m_frequency_stream = CreateObject<NormalRandomVariable>();
 }
 
 SafApplication::~SafApplication() {
@@ -250,6 +314,9 @@ SafApplication::~SafApplication() {
 
 void SafApplication::DoDispose(void) {
   NS_LOG_FUNCTION(this);
+  m_catalog = 0;
+  m_allocation_policy = 0;
+  m_stats = 0;
   Application::DoDispose();
 }
 
@@ -265,9 +332,43 @@ void SafApplication::StartApplication(void) {
   // optimized builds
   m_origianal_space = m_total_data_items / m_total_num_nodes;
 
-  // m_origianal_data_items = std::vector<Data>(m_origianal_space);
-  // m_replica_data_items = std::vector<Data>(m_replica_space);
-  m_access_frequencies = std::vector<std::vector<uint16_t>>(m_total_data_items);
+  // the IDs only depend on the index, so nodes need no shared state
+  if (m_node_index == NODE_ID_INDEX) {
+    m_node_index = GetNode()->GetId();
+  }
+  NS_ABORT_MSG_IF(
+      m_node_index >= m_total_num_nodes,
+      "The node index " << m_node_index << " must be below NumNodes " << m_total_num_nodes);
+  m_message_ids.Init(m_node_index, m_total_num_nodes);
+
+  m_timeouts.SetResolution(m_timeout_resolution);
+
+  m_codec.SetWireFormat(m_wire_format);
+  m_codec.Reserve(m_dataSize);
+
+  // enough for a lookup and a reallocation of every item to be pending at once
+  m_pending_requests.Reserve(2 * m_total_data_items);
+  m_inflight_lookups.assign(m_total_data_items + 1, 0);  // data IDs start at 1
+  m_location_cache.Init(m_total_data_items, m_location_cache_size);
+  m_seen_requests.Init(SEEN_REQUESTS);  // peers may forward even when this node does not
+
+  m_origianal_data_items.Init(m_total_data_items, m_origianal_space);
+  m_replica_data_items.Init(m_total_data_items, m_replica_space);
+  m_replica_ranks.Init(m_total_data_items);
+
+  // in access frequency mode 3 every node draws its own frequencies
+  if (m_catalog == 0 || !SafCatalog::IsShareable(m_access_frequency_type)) {
+    m_catalog = CreateObject<SafCatalog>();
+    m_catalog->Init(
+        m_total_data_items,
+        m_access_frequency_type,
+        m_standard_deviation,
+        m_reallocation_period,
+        m_frequency_stream);
+  }
+  NS_ASSERT_MSG(
+      m_catalog->GetTotalItems() == m_total_data_items,
+      "The catalog must hold every data item");
 
   if (m_socket_recv == 0) {
     TypeId tid = TypeId::LookupByName("ns3::UdpSocketFactory");
@@ -288,26 +389,30 @@ void SafApplication::StartApplication(void) {
   m_socket_recv->SetRecvCallback(MakeCallback(&SafApplication::HandleRequest, this));
   m_socket_send->SetRecvCallback(MakeCallback(&SafApplication::HandleResponse, this));
   m_socket_send->SetAllowBroadcast(true);
-  m_socket_send->SetIpTtl(2);  // or should this be 0? to only send to 1 hop peers
+  m_socket_send->SetIpTtl(REQUEST_TTL);  // or should this be 0? to only send to 1 hop peers
 
-  // fill access frequencies using random values
-  // then sort the access frequencies
-  GenerateDataItems();
+  // the received TTL tells how far away the requester is when backing off
+  m_socket_recv->SetIpRecvTtl(m_response_suppression);
 
-  for (uint16_t i = 1; i <= m_total_data_items; i++) {
-    double accessFrequency = CalculateAccessFrequency(i);
-    double lookupDelay =
-        m_reallocation_period.GetSeconds() - (m_reallocation_period.GetSeconds() * accessFrequency);
+  GenerateDataItems();
 
-    Ptr<ExponentialRandomVariable> e = CreateObject<ExponentialRandomVariable>();
-    e->SetAttribute("Mean", DoubleValue(lookupDelay));
-    m_data_lookup_generator.push_back(e);
-    std::vector<uint16_t> row(2);
-    row[0] = i;                   // dataID
-    row[1] = lookupDelay * 1000;  // to convert to an int
-    m_access_frequencies[i - 1] = row;
+  // the replicas this node wants to hold are decided by the policy every reallocation round
+  if (m_allocation_policy == 0 || m_allocation_policy->GetScheme() != m_replica_allocation) {
+    m_allocation_policy = ReplicaAllocationPolicy::Create(m_replica_allocation);
+    m_allocation_policy->SetAttribute("Range", DoubleValue(m_neighbor_range));
+  }
+  m_allocation_member = m_allocation_policy->AddMember(
+      GetNode(),
+      m_catalog,
+      m_origianal_data_items,
+      m_replica_space);
+  m_wanted_replicas.Init(m_total_data_items);
+  m_missing_replicas.Init(m_total_data_items);
+  m_overheard_items.Init(m_total_data_items);
+
+  if (m_lookup_engine == AGGREGATE) {
+    m_lookup_sampler.Init(m_catalog->GetLookupDelays());
   }
-  sort(m_access_frequencies.begin(), m_access_frequencies.end(), AccessFrequencyComparator);
 
   // schedule first reallocation event
   m_reallocation_event =
@@ -333,48 +438,55 @@ void SafApplication::StopApplication() {
     m_socket_send = 0;
   }
 
-  // check to see if it is still in the pending lookup list
-  for (std::set<uint32_t>::iterator it = m_pending_lookups.begin(); it != m_pending_lookups.end();
-       it++) {
-    NS_LOG_INFO("TODO: sim ended before application request ID " << *it << " timed out");
-  }
+  NS_LOG_INFO(
+      "TODO: sim ended before " << m_pending_requests.GetSize() << " pending requests timed out");
+  m_pending_requests.Clear();
+  m_inflight_lookups.assign(m_inflight_lookups.size(), 0);
 
-  // check to see if it is still in the pending lookup list
-  for (std::set<uint32_t>::iterator it = m_pending_reallocations.begin();
-       it != m_pending_reallocations.end();
-       it++) {
-    NS_LOG_INFO("TODO: sim ended before reallocation request ID " << *it << " timed out");
+  for (size_t i = 0; i < m_scheduled_responses.size(); i++) {
+    Simulator::Cancel(m_scheduled_responses[i].event);
   }
+  m_scheduled_responses.clear();
 
   Simulator::Cancel(m_reallocation_event);
-}
-
-double SafApplication::CalculateAccessFrequency(uint16_t dataID) {
-  if (m_access_frequency_type == 1) {
-    return 0.5 * (1.0 + 0.01 * dataID);
-  } else if (m_access_frequency_type == 2) {
-    return 0.025 * dataID;
-  } else if (m_access_frequency_type == 3) {
-    Ptr<NormalRandomVariable> x = CreateObject<NormalRandomVariable>();
-    x->SetAttribute("Mean", DoubleValue(0.5 * (1.0 + 0.01 * dataID)));
-    x->SetAttribute("Variance", DoubleValue(pow(m_standard_deviation, 2.0)));
-
-    return x->GetValue();
-  } else {
-    NS_LOG_ERROR("this is bad, the access frequency mode must be 1, 2, or 3");
-    return 0;
-  }
+  Simulator::Cancel(m_lookup_event);
+  m_timeouts.Clear();
 }
 
 void SafApplication::ScheduleFirstLookups() {
   NS_LOG_FUNCTION(this);
 
+  if (m_lookup_engine == AGGREGATE) {
+    ScheduleAggregateLookup();
+    return;
+  }
+
+  // items without a positive mean are never looked up, the same as with AGGREGATE
   for (uint16_t i = 1; i <= m_total_data_items; i++) {
-    double dt = m_data_lookup_generator[i - 1]->GetValue();
-    Simulator::Schedule(Seconds(dt), &SafApplication::ScheduleNextLookup, this, i);
+    double mean = m_catalog->GetLookupDelay(i);
+    if (mean > 0.0) {
+      Simulator::Schedule(
+          Seconds(DrawExponential(mean)),
+          &SafApplication::ScheduleNextLookup,
+          this,
+          i);
+    }
   }
 }
 
+double SafApplication::DrawExponential(double mean) {
+  // inverse transform sampling, u is in [0, 1) so the log is always finite
+  return -mean * log(1.0 - m_lookup_stream->GetValue());
+}
+
+int64_t SafApplication::AssignStreams(int64_t stream) {
+  NS_LOG_FUNCTION(this << stream);
+  m_lookup_stream->SetStream(stream);
+  m_backoff->SetStream(stream + 1);
+  m_frequency_stream->SetStream(stream + 2);
+  return 3;
+}
+
 void SafApplication::ScheduleNextLookup(uint16_t dataID) {
   NS_LOG_FUNCTION(this);
   // dont schedule the next event if it is no longer running
@@ -384,12 +496,40 @@ void SafApplication::ScheduleNextLookup(uint16_t dataID) {
   }
 
   LookupData(dataID);
-  double dt = m_data_lookup_generator[dataID - 1]->GetValue();
+  double dt = DrawExponential(m_catalog->GetLookupDelay(dataID));
   if (Simulator::Now() + Seconds(dt) < m_stopTime) {
     Simulator::Schedule(Seconds(dt), &SafApplication::ScheduleNextLookup, this, dataID);
   }
 }
 
+void SafApplication::ScheduleAggregateLookup() {
+  NS_LOG_FUNCTION(this);
+
+  double rate = m_lookup_sampler.GetTotalRate();
+  if (rate <= 0.0) {
+    return;
+  }
+
+  // the time until any of the items is looked up is exponential with the summed rate
+  double dt = DrawExponential(1.0 / rate);
+  if (Simulator::Now() + Seconds(dt) < m_stopTime) {
+    m_lookup_event = Simulator::Schedule(Seconds(dt), &SafApplication::RunAggregateLookup, this);
+  }
+}
+
+void SafApplication::RunAggregateLookup() {
+  NS_LOG_FUNCTION(this);
+  if (!m_running) {
+    NS_LOG_INFO("Simulation done, canceling lookup");
+    return;
+  }
+
+  // pick the item in proportion to its own lookup rate
+  double u = m_lookup_stream->GetValue(0.0, m_lookup_sampler.GetTotalRate());
+  LookupData(m_lookup_sampler.Pick(u));
+  ScheduleAggregateLookup();
+}
+
 void SafApplication::HandleRequest(Ptr<Socket> socket) {
   NS_LOG_FUNCTION(this << socket);
 
@@ -407,85 +547,241 @@ void SafApplication::HandleRequest(Ptr<Socket> socket) {
     m_rxTrace(packet);
     m_rxTraceWithAddresses(packet, from, localAddress);
 
-    uint32_t size = packet->GetSize();
-    uint8_t* payload = new uint8_t[size];
-    packet->CopyData(payload, size);
-
-    saf::packets::Message recvd;
-    bool status = recvd.ParseFromArray(payload, size);
-    delete[] payload;
+    SafHeader recvd;
+    bool status = m_codec.Decode(packet, recvd);
+    m_rxCopiedTrace(m_codec.GetCopiedBytes());
     if (!status) {
       NS_LOG_ERROR("Failed to parse the payload");
+      continue;
     }
 
-    if (recvd.has_request()) {
-      NS_LOG_INFO("RECEIVED lookup command");
+    if (recvd.IsResponse()) {
+      if (RelayResponse(recvd)) {
+        continue;
+      }
 
-      saf::packets::Request req = recvd.request();
-      uint32_t requestID = recvd.id();
-      uint64_t sentAt = recvd.timestamp();
-      uint16_t dataID = req.data_id();
-      bool isReplication = req.replication_request();
+      // only sent here when responders broadcast, so other responders can hear it
+      LearnLocations(recvd, from);
+      CancelResponse(recvd);
+      ProcessResponse(recvd, true);
+      continue;
+    }
 
-      // mark that the lookup request was received, this is to be able to detect
-      // collisions
-      if (isReplication) {
-        if (!m_realloc_rcv_CB.IsNull()) m_realloc_rcv_CB(dataID, GetNode()->GetId());
-      } else {
-        if (!m_lookup_rcv_CB.IsNull()) m_lookup_rcv_CB(dataID, GetNode()->GetId());
-      }
+    NS_LOG_INFO("RECEIVED lookup command");
 
-      Data item = GetDataItem(dataID);
-      if (item.GetStatus() != DataStatus::stored) {
-        NS_LOG_INFO("Data item not found, not sending response");
-        continue;
+    // a flood reaches a node over more than one path, only the first copy counts
+    if (recvd.IsMultiHop() && !m_seen_requests.Insert(recvd.GetId(), from, Simulator::Now())) {
+      NS_LOG_INFO("Dropping a request that was already seen");
+      continue;
+    }
+
+    // mark that the lookup request was received, this is to be able to detect
+    // collisions
+    if (recvd.IsBatch()) {
+      for (uint16_t i = 0; i < recvd.GetItemCount(); i++) {
+        ReportRequestReceived(recvd.GetItem(i).dataID, recvd.IsReplication());
       }
+    } else {
+      ReportRequestReceived(recvd.GetDataID(), recvd.IsReplication());
+    }
+
+    if (!HoldsRequestedItem(recvd)) {
+      NS_LOG_INFO("Data item not found, not sending response");
+      ForwardRequest(recvd);
+      continue;
+    }
 
+    if (!m_response_suppression) {
       NS_LOG_INFO("sending response");
-      // generate and send response
+      if (m_broadcast_responses) {
+        m_socket_send->Send(MakeResponse(recvd));
+      } else {
+        socket->SendTo(MakeResponse(recvd), 0, from);
+      }
+      NS_LOG_INFO("sent packet");
+      continue;
+    }
 
-      saf::packets::Message send;
-      saf::packets::Response* resp = send.mutable_response();
+    // responders further away from the requester back off for longer, so the
+    // nearest one usually answers first and the others hear it and cancel
+    SocketIpTtlTag ttl;
+    uint8_t hops = 1;
+    if (packet->PeekPacketTag(ttl) && ttl.GetTtl() <= REQUEST_TTL) {
+      hops = REQUEST_TTL - ttl.GetTtl() + 1;
+    }
+    hops += recvd.GetHops();
+    double backoff = m_suppression_backoff.GetSeconds() * (hops - 1 + m_backoff->GetValue());
+
+    ScheduledResponse response;
+    response.request = recvd;
+    response.event = Simulator::Schedule(
+        Seconds(backoff),
+        &SafApplication::SendScheduledResponse,
+        this,
+        recvd.GetId());
+    m_scheduled_responses.push_back(response);
+  }
+}
+
+void SafApplication::Count(SafStatsSink::Counter counter, uint16_t dataID) {
+  if (m_stats != 0) {
+    m_stats->Count(counter, dataID, GetNode()->GetId());
+  }
+}
+
+void SafApplication::Record(SafStatsSink::Delay delay, uint16_t dataID, Time value) {
+  if (m_stats != 0) {
+    m_stats->Record(delay, dataID, GetNode()->GetId(), value);
+  }
+}
+
+void SafApplication::ReportRequestReceived(uint16_t dataID, bool isReplication) {
+  if (isReplication) {
+    Count(SafStatsSink::REALLOC_RCV, dataID);
+  } else {
+    Count(SafStatsSink::LOOKUP_RCV, dataID);
+  }
+}
+
+bool SafApplication::HoldsRequestedItem(const SafHeader& request) const {
+  if (!request.IsBatch()) {
+    return GetStoredItem(request.GetDataID()) != 0;
+  }
+
+  for (uint16_t i = 0; i < request.GetItemCount(); i++) {
+    if (GetStoredItem(request.GetItem(i).dataID) != 0) {
+      return true;
+    }
+  }
+  return false;
+}
 
-      payload = new uint8_t[item.GetSize()];
+Ptr<Packet> SafApplication::MakeResponse(const SafHeader& request) {
+  bool isReplication = request.IsReplication();
 
-      resp->set_data_id(item.GetDataID());
-      resp->set_replication_request(isReplication);
-      resp->set_data(payload, item.GetSize());
+  SafHeader send;
+  send.SetResponse(true);
+  send.SetReplication(isReplication);
 
-      // send.set_response(resp);
-      send.set_timestamp(Simulator::Now().GetMilliSeconds());
-      send.set_original_sent_at(sentAt);
-      send.set_response_to(requestID);
-      send.set_id(SafApplication::GenMessageID());
+  send.SetTimestamp(Simulator::Now().GetMilliSeconds());
+  send.SetOriginalSentAt(request.GetTimestamp());
+  send.SetResponseTo(request.GetId());
+  send.SetHopLimit(request.GetHopLimit());
 
-      delete[] payload;
+  if (!request.IsBatch()) {
+    const Data* item = GetStoredItem(request.GetDataID());
+    if (item == 0) {
+      return 0;
+    }
 
-      size = send.ByteSizeLong();
-      payload = new uint8_t[size];
-      status = send.SerializeToArray(payload, size);
-      if (!status) {
-        NS_LOG_ERROR("Failed to serialize the message for transmission");
+    send.SetDataID(item->GetDataID());
+    send.SetDataSize(item->GetSize());
+    ReportResponseSent(item->GetDataID(), isReplication);
+  } else {
+    // one aggregated reply carrying every requested item this node holds
+    for (uint16_t i = 0; i < request.GetItemCount(); i++) {
+      const Data* item = GetStoredItem(request.GetItem(i).dataID);
+      if (item != 0) {
+        send.AddItem(item->GetDataID(), request.GetItem(i).offset, item->GetSize());
+        ReportResponseSent(item->GetDataID(), isReplication);
       }
+    }
 
-      Ptr<Packet> responsePacket = Create<Packet>(payload, size);
-      delete[] payload;
+    if (send.GetItemCount() == 0) {
+      return 0;
+    }
+  }
 
-      if (isReplication) {
-        if (!m_realloc_rsp_sent_CB.IsNull()) m_realloc_rsp_sent_CB(dataID, GetNode()->GetId());
-      } else {
-        if (!m_lookup_rsp_sent_CB.IsNull()) m_lookup_rsp_sent_CB(dataID, GetNode()->GetId());
+  send.SetId(GenMessageID());
+  return m_codec.Encode(send);
+}
+
+void SafApplication::ReportResponseSent(uint16_t dataID, bool isReplication) {
+  if (isReplication) {
+    Count(SafStatsSink::REALLOC_RSP_SENT, dataID);
+  } else {
+    Count(SafStatsSink::LOOKUP_RSP_SENT, dataID);
+  }
+}
+
+void SafApplication::SendScheduledResponse(uint32_t requestID) {
+  NS_LOG_FUNCTION(this << requestID);
+
+  for (size_t i = 0; i < m_scheduled_responses.size(); i++) {
+    if (m_scheduled_responses[i].request.GetId() != requestID) {
+      continue;
+    }
+
+    ScheduledResponse response = m_scheduled_responses[i];
+    m_scheduled_responses[i] = m_scheduled_responses.back();
+    m_scheduled_responses.pop_back();
+
+    // the items may have been evicted while backing off
+    Ptr<Packet> packet = MakeResponse(response.request);
+    if (packet == 0) {
+      return;
+    }
+
+    // broadcast so that the other responders hear it and cancel theirs
+    m_socket_send->Send(packet);
+    NS_LOG_INFO("sent packet");
+    return;
+  }
+}
+
+void SafApplication::CancelResponse(const SafHeader& response) {
+  for (size_t i = 0; i < m_scheduled_responses.size(); i++) {
+    SafHeader& request = m_scheduled_responses[i].request;
+    if (request.GetId() != response.GetResponseTo()) {
+      continue;
+    }
+
+    // the other responder may only hold some of the items of a batch, the rest
+    // are still sent once the backoff expires
+    if (request.IsBatch()) {
+      for (uint16_t n = 0; n < response.GetItemCount(); n++) {
+        if (request.RemoveItem(response.GetItem(n).dataID)) {
+          Count(SafStatsSink::RSP_SUPPRESSED, response.GetItem(n).dataID);
+        }
       }
 
-      socket->SendTo(responsePacket, 0, from);
-      NS_LOG_INFO("sent packet");
+      if (request.GetItemCount() > 0) {
+        return;
+      }
+    } else {
+      Count(SafStatsSink::RSP_SUPPRESSED, request.GetDataID());
     }
+
+    Simulator::Cancel(m_scheduled_responses[i].event);
+    m_scheduled_responses[i] = m_scheduled_responses.back();
+    m_scheduled_responses.pop_back();
+    return;
   }
 }
 
-uint32_t SafApplication::GenMessageID() {
-  static uint32_t id = 0;
-  return ++id;
+uint32_t SafApplication::GenMessageID(uint16_t count) {
+  uint32_t first = m_message_ids.Next(count);
+
+  // once the counter started over an ID may still be waiting on its answer, or be
+  // remembered as seen so its copies are dropped, those are skipped. Batches do not
+  // wrap around, so the first ID may never come back. The tries are bounded by the
+  // counter instead: the batches left before it starts over, then every batch from 1
+  uint32_t tries = 1;
+  uint32_t maxTries = 2 * (m_message_ids.GetCapacity() / count) + 1;
+  while (m_message_ids.HasWrapped() && IsMessageIDInUse(first, count)) {
+    NS_ABORT_MSG_IF(tries++ == maxTries, "Every message ID of the node is in use");
+    first = m_message_ids.Next(count);
+  }
+  return first;
+}
+
+bool SafApplication::IsMessageIDInUse(uint32_t first, uint16_t count) const {
+  for (uint32_t id = first; id < first + count; id++) {
+    if (m_pending_requests.Find(id) != 0 || m_seen_requests.Contains(id)) {
+      return true;
+    }
+  }
+  return false;
 }
 
 void SafApplication::HandleResponse(Ptr<Socket> socket) {
@@ -506,64 +802,165 @@ void SafApplication::HandleResponse(Ptr<Socket> socket) {
     m_rxTrace(packet);
     m_rxTraceWithAddresses(packet, from, localAddress);
 
-    uint32_t size = packet->GetSize();
-    uint8_t* payload = new uint8_t[size];
-    packet->CopyData(payload, size);
-
-    saf::packets::Message recvd;
-    bool status = recvd.ParseFromArray(payload, size);
-    delete[] payload;
+    SafHeader recvd;
+    bool status = m_codec.Decode(packet, recvd);
+    m_rxCopiedTrace(m_codec.GetCopiedBytes());
     if (!status) {
       NS_LOG_ERROR("Failed to parse the payload");
+      continue;
     }
 
-    NS_LOG_INFO("handling data received: " << payload[0]);
-
-    if (recvd.has_response()) {
-      NS_LOG_INFO("handling data received");
-      saf::packets::Response resp = recvd.response();
-
-      uint32_t origID = recvd.response_to();
-      uint64_t askTime = recvd.original_sent_at();
-      uint16_t dataID = resp.data_id();
-      const std::string& data = resp.data();
-      bool isReplication = resp.replication_request();
-      uint32_t dataSize = data.size();
-
-      Data item = Data(dataID, dataSize);
-      SaveDataItem(item);
-
-      // remove from pending request list
-      std::set<uint32_t>::iterator it;
-      Time diff = Simulator::Now() - Time::FromInteger(askTime, Time::Unit::MS);
-
-      if (isReplication) {
-        it = m_pending_reallocations.find(origID);
-        if (it != m_pending_reallocations.end()) {
-          m_pending_reallocations.erase(it);
-          if (!m_realloc_ontime_CB.IsNull()) m_realloc_ontime_CB(dataID, GetNode()->GetId(), diff);
-          // log successful request
-        } else {
-          // log successful request, already gotten or late
-          if (!m_realloc_late_CB.IsNull()) m_realloc_late_CB(dataID, GetNode()->GetId(), diff);
-        }
-      } else {
-        it = m_pending_lookups.find(origID);
-        if (it != m_pending_lookups.end()) {
-          m_pending_lookups.erase(it);
-          if (!m_lookup_ontime_CB.IsNull()) m_lookup_ontime_CB(dataID, GetNode()->GetId(), diff);
-          // log successful request
-        } else {
-          // log successful request, already gotten or late
-          if (!m_lookup_late_CB.IsNull()) m_lookup_late_CB(dataID, GetNode()->GetId(), diff);
-        }
+    if (recvd.IsResponse() && !RelayResponse(recvd)) {
+      LearnLocations(recvd, from);
+      ProcessResponse(recvd, false);
+    }
+  }
+}
+
+void SafApplication::LearnLocations(const SafHeader& recvd, const Address& from) {
+  // a relayed response comes from the relay and not from the holder
+  if (m_location_cache.GetCapacity() == 0 || recvd.GetHops() > 0 ||
+      !InetSocketAddress::IsMatchingType(from)) {
+    return;
+  }
+
+  Ipv4Address holder = InetSocketAddress::ConvertFrom(from).GetIpv4();
+  if (!recvd.IsBatch()) {
+    m_location_cache.Learn(recvd.GetDataID(), holder, Simulator::Now());
+    return;
+  }
+
+  for (uint16_t i = 0; i < recvd.GetItemCount(); i++) {
+    m_location_cache.Learn(recvd.GetItem(i).dataID, holder, Simulator::Now());
+  }
+}
+
+void SafApplication::ForwardRequest(const SafHeader& request) {
+  if (request.GetHops() + 1 >= request.GetHopLimit()) {
+    return;
+  }
+
+  SafHeader forward = request;
+  forward.SetHops(request.GetHops() + 1);
+  SendRequest(m_codec.Encode(forward), Ipv4Address::GetBroadcast());
+
+  Count(SafStatsSink::REQUEST_FORWARDED, request.GetDataID());
+}
+
+bool SafApplication::RelayResponse(const SafHeader& response) {
+  // the requester has given up on requests older than the timeout
+  Address previous;
+  if (!response.IsMultiHop() ||
+      !m_seen_requests.TakeRoute(
+          response.GetResponseTo(),
+          Simulator::Now() - m_request_timeout,
+          previous)) {
+    return false;
+  }
+
+  SafHeader relay = response;
+  relay.SetHops(response.GetHops() + 1);
+  m_socket_recv->SendTo(m_codec.Encode(relay), 0, previous);
+
+  // none of the items are pending here, so they are only cached
+  if (m_cache_overheard) {
+    ProcessResponse(response, true);
+  }
+  return true;
+}
+
+void SafApplication::ProcessResponse(const SafHeader& recvd, bool onlyPending) {
+  NS_LOG_INFO("handling data received");
+
+  if (!recvd.IsBatch()) {
+    ProcessItem(recvd, recvd.GetResponseTo(), recvd.GetDataID(), recvd.GetDataSize(), onlyPending);
+    return;
+  }
+
+  // item i of a batched request was sent with the request ID plus i
+  for (uint16_t i = 0; i < recvd.GetItemCount(); i++) {
+    const SafHeader::Item& item = recvd.GetItem(i);
+    ProcessItem(recvd, recvd.GetResponseTo() + item.offset, item.dataID, item.size, onlyPending);
+  }
+}
+
+void SafApplication::ProcessItem(
+    const SafHeader& recvd,
+    uint32_t origID,
+    uint16_t dataID,
+    uint32_t dataSize,
+    bool onlyPending) {
+  // an earlier attempt of a lookup that has since been retried is answered
+  // late, which still answers the lookup itself
+  if (!recvd.IsReplication() && m_pending_requests.Find(origID) == 0) {
+    uint32_t retryID = FindRetry(dataID, recvd.GetOriginalSentAt());
+    if (retryID != 0) {
+      origID = retryID;
+    }
+  }
+
+  if (onlyPending && m_pending_requests.Find(origID) == 0) {
+    if (m_cache_overheard) {
+      CacheOverheardItem(dataID, dataSize);
+    }
+    return;
+  }
+
+  uint32_t askTime = recvd.GetOriginalSentAt();
+  bool isReplication = recvd.IsReplication();
+
+  Data item = Data(dataID, dataSize);
+  SaveDataItem(item);
+
+  // remove from pending request list
+  PendingRequest request;
+  bool pending = m_pending_requests.Remove(origID, request);
+  Time diff = pending ? Simulator::Now() - request.sendTime
+                      : Simulator::Now() - Time::FromInteger(askTime, Time::Unit::MS);
+
+  if (isReplication) {
+    if (pending) {
+      Record(SafStatsSink::REALLOC_ONTIME, dataID, diff);
+      // log successful request
+    } else {
+      // log successful request, already gotten or late
+      Record(SafStatsSink::REALLOC_LATE, dataID, diff);
+    }
+  } else {
+    if (pending) {
+      ReleaseLookup(request);
+      Record(SafStatsSink::LOOKUP_ONTIME, dataID, diff);
+      for (uint16_t i = 0; i < request.waiters; i++) {
+        Record(SafStatsSink::LOOKUP_COALESCED_ONTIME, dataID, diff);
       }
+      // log successful request
+    } else {
+      // log successful request, already gotten or late
+      Record(SafStatsSink::LOOKUP_LATE, dataID, diff);
+    }
+  }
 
-      NS_LOG_LOGIC(
-          "TODO: Mark cache miss, mark lookup success, remove from "
-          "pending reponse list");
+  NS_LOG_LOGIC(
+      "TODO: Mark cache miss, mark lookup success, remove from "
+      "pending reponse list");
+}
+
+
+void SafApplication::CacheOverheardItem(uint16_t dataID, uint32_t dataSize) {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  if (!m_replica_data_items.Contains(dataID)) {
+    SaveDataItem(Data(dataID, dataSize));
+    if (m_replica_data_items.Contains(dataID)) {
+      m_overheard_items.Insert(dataID);
+      Count(SafStatsSink::OVERHEARD_SAVED, dataID);
     }
   }
+
+  m_overheardTimeTrace(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now() - start)
+                           .count());
+  Count(SafStatsSink::OVERHEARD_RCV, dataID);
 }
 
 // ---------------------------------------------------------------
@@ -571,174 +968,347 @@ void SafApplication::HandleResponse(Ptr<Socket> socket) {
 
 void SafApplication::GenerateDataItems() {
   NS_LOG_FUNCTION(this);
+  // node i owns the items after the ones of nodes 0 to i - 1
+  uint16_t first = m_node_index * m_origianal_space + 1;
   for (int i = 0; i < m_origianal_space; i++) {
-    m_origianal_data_items.push_back(Data(m_dataSize));
+    m_origianal_data_items.Add(Data(first + i, m_dataSize, DataType::origianal));
   }
 }
 
 void SafApplication::LookupData(uint16_t dataID) {
   NS_LOG_FUNCTION(this);
-  Data item = GetDataItem(dataID);
+  const Data* item = GetDataItem(dataID);
 
-  if (item.GetStatus() == DataStatus::stored) {
-    if (!m_cache_hit_CB.IsNull()) m_cache_hit_CB(dataID, GetNode()->GetId());
+  if (item != 0 && item->GetStatus() == DataStatus::stored) {
+    Count(SafStatsSink::CACHE_HIT, dataID);
+    if (m_overheard_items.Contains(dataID)) {
+      Count(SafStatsSink::OVERHEARD_HIT, dataID);
+    }
+  } else if (m_coalesce_lookups && AttachLookup(dataID)) {
+    Count(SafStatsSink::LOOKUP_COALESCED, dataID);
   } else {
     // send broadcast asking for the data item
     AskPeers(dataID, false);
   }
 }
 
+uint32_t SafApplication::FindRetry(uint16_t dataID, uint32_t askTime) const {
+  if (m_inflight_lookups[dataID] == 0) {
+    return 0;
+  }
+
+  // every attempt of a lookup carries the time the lookup was first sent
+  const PendingRequest* request = m_pending_requests.Find(m_inflight_lookups[dataID]);
+  if (request == 0 || request->retries == 0 ||
+      (uint32_t)request->sendTime.GetMilliSeconds() != askTime) {
+    return 0;
+  }
+  return request->requestID;
+}
+
+bool SafApplication::AttachLookup(uint16_t dataID) {
+  if (m_inflight_lookups[dataID] == 0) {
+    return false;
+  }
+
+  PendingRequest* request = m_pending_requests.Find(m_inflight_lookups[dataID]);
+  NS_ASSERT_MSG(request != 0, "in flight lookups must be pending");
+  request->waiters++;
+  return true;
+}
+
+void SafApplication::ReleaseLookup(const PendingRequest& request) {
+  if (m_inflight_lookups[request.dataID] == request.requestID) {
+    m_inflight_lookups[request.dataID] = 0;
+  }
+}
+
 void SafApplication::SaveDataItem(Data data) {
   NS_LOG_FUNCTION(this);
 
-  bool found = false;
-  bool stored = false;
-  for (std::vector<Data>::iterator it = m_replica_data_items.begin();
-       it != m_replica_data_items.end();
-       ++it) {
-    if (!found && m_access_frequencies[it - m_replica_data_items.begin()][0] == data.GetDataID()) {
-      found = true;
-    }
+  uint16_t dataID = data.GetDataID();
+  if (m_origianal_data_items.Contains(dataID) || m_replica_data_items.Contains(dataID)) {
+    return;
+  }
 
-    if (!stored && (*it).GetDataID() == data.GetDataID()) {
-      stored = true;
+  // keep the wanted and then the most frequently accessed items, so once the
+  // store is full an item is only admitted in place of a replica that ranks below it
+  uint32_t rank = GetReplicaRank(dataID);
+  if (m_replica_data_items.IsFull()) {
+    if (m_replica_ranks.IsEmpty() || rank >= m_replica_ranks.GetLowestRank()) {
+      NS_LOG_INFO("data: " << dataID << " Is not being saved");
+      return;
     }
+    EvictDataItem(m_replica_ranks.GetLowest());
   }
-  if (!found || stored) {
-    NS_LOG_INFO("data: " << data.GetDataID() << " Is not being saved");
+
+  m_replica_data_items.Add(data);
+  m_replica_ranks.Insert(dataID, rank);
+  m_missing_replicas.Erase(dataID);
+}
+
+void SafApplication::EvictDataItem(uint16_t dataID) {
+  NS_LOG_FUNCTION(this);
+
+  if (!m_replica_data_items.Remove(dataID)) {
+    return;
   }
 
-  if (m_replica_data_items.size() < m_replica_space) {
-    m_replica_data_items.push_back(data);
+  NS_LOG_INFO("data: " << dataID << " Is evicted");
+  m_replica_ranks.Remove(dataID);
+  m_overheard_items.Erase(dataID);
+  if (m_wanted_replicas.Contains(dataID)) {
+    m_missing_replicas.Insert(dataID);
   }
 }
 
-Data SafApplication::GetDataItem(uint16_t dataID) {
+const Data* SafApplication::GetStoredItem(uint16_t dataID) const {
+  const Data* item = GetDataItem(dataID);
+  return (item != 0 && item->GetStatus() == DataStatus::stored) ? item : 0;
+}
+
+const Data* SafApplication::GetDataItem(uint16_t dataID) const {
   NS_LOG_FUNCTION(this);
-  for (int i = 0; i < m_origianal_space; i++) {
-    if (m_origianal_data_items[i].GetDataID() == dataID) {
-      return m_origianal_data_items[i];
-    }
+  const Data* item = m_origianal_data_items.Find(dataID);
+  if (item != 0) {
+    return item;
   }
 
-  for (std::vector<Data>::iterator it = m_replica_data_items.begin();
-       it != m_replica_data_items.end();
-       ++it) {
-    if ((*it).GetDataID() == dataID) {
-      return (*it);
-    }
+  return m_replica_data_items.Find(dataID);
+}
+
+void SafApplication::AskPeers(uint16_t dataID, bool isReplication) {
+  NS_LOG_FUNCTION(this);
+
+  uint32_t reqID = GenMessageID();
+
+  SafHeader send;
+  send.SetDataID(dataID);
+  send.SetReplication(isReplication);
+
+  send.SetTimestamp(Simulator::Now().GetMilliSeconds());
+  send.SetId(reqID);
+
+  // lookups go straight to the last known holder, falling back to a broadcast on a timeout
+  Ipv4Address destination = Ipv4Address::GetBroadcast();
+  bool unicast = !isReplication &&
+                 m_location_cache.Lookup(
+                     dataID,
+                     Simulator::Now() - m_location_cache_lifetime,
+                     destination);
+
+  // broadcast lookups start with the smallest ring, peers forward them that far
+  uint8_t hopLimit = isReplication || unicast ? 0 : GetFirstRing();
+  if (hopLimit > 0) {
+    send.SetHopLimit(hopLimit);
+    m_seen_requests.Insert(reqID, Address(), Simulator::Now());
   }
 
-  return Data();
+  TrackRequest(reqID, dataID, isReplication, unicast, hopLimit);
+  SendRequest(m_codec.Encode(send), destination);
+
+  NS_LOG_INFO(
+      "At time " << Simulator::Now().GetSeconds() << "s sent request for " << dataID << " to "
+                 << destination);
 }
 
-void SafApplication::AskPeers(uint16_t dataID, bool isReplication) {
+void SafApplication::RetryAsBroadcast(const PendingRequest& request, uint8_t hopLimit) {
   NS_LOG_FUNCTION(this);
 
-  uint32_t reqID = SafApplication::GenMessageID();
-  saf::packets::Message send;
-  saf::packets::Request* req = send.mutable_request();
+  uint32_t reqID = GenMessageID();
 
-  req->set_data_id(dataID);
-  req->set_replication_request(isReplication);
+  // keep the original send time so the lookup delay includes the earlier attempts
+  SafHeader send;
+  send.SetDataID(request.dataID);
+  send.SetTimestamp(request.sendTime.GetMilliSeconds());
+  send.SetId(reqID);
+  send.SetHopLimit(hopLimit);
 
-  send.set_timestamp(Simulator::Now().GetMilliSeconds());
-  send.set_id(reqID);
+  // copies of the request forwarded back to this node are dropped
+  if (hopLimit > 0) {
+    m_seen_requests.Insert(reqID, Address(), Simulator::Now());
+  }
 
-  uint32_t size = send.ByteSizeLong();
-  uint8_t* payload = new uint8_t[size];
-  bool status = send.SerializeToArray(payload, size);
-  if (!status) {
-    NS_LOG_ERROR("Failed to serialize the message for transmission");
+  PendingRequest retry = request;
+  retry.requestID = reqID;
+  retry.retries++;
+  retry.unicast = false;
+  retry.hopLimit = hopLimit;
+  m_pending_requests.Insert(retry);
+
+  Time timeout = GetRequestTimeout(hopLimit);
+  if (Simulator::Now() + timeout < m_stopTime) {
+    m_timeouts.Push(timeout, reqID, retry.kind);
+    m_inflight_lookups[retry.dataID] = reqID;
   }
 
-  Ptr<Packet> packet = Create<Packet>(payload, size);
-  delete[] payload;
+  SendRequest(m_codec.Encode(send), Ipv4Address::GetBroadcast());
+}
 
-  Address localAddress;
-  m_socket_send->GetSockName(localAddress);
+uint8_t SafApplication::GetFirstRing() const { return m_max_hops > 1 ? 1 : 0; }
 
-  // call to the trace sinks before the packet is actually sent,
-  // so that tags added to the packet can be sent as well
-  m_txTrace(packet);
-  m_txTraceWithAddresses(
-      packet,
-      localAddress,
-      InetSocketAddress(Ipv4Address::GetBroadcast(), m_port));
+Time SafApplication::GetRequestTimeout(uint8_t hopLimit) const {
+  // a ring only has to wait for answers from as far as it reaches, the widest one waits in full
+  if (hopLimit == 0) {
+    return m_request_timeout;
+  }
+  return NanoSeconds(m_request_timeout.GetNanoSeconds() * hopLimit / m_max_hops);
+}
 
-  // TODO: use add a hook to the router to get all of the other one hop nodes in
-  // the routing table to get the total number of recipients
+void SafApplication::AskPeers(const std::vector<uint16_t>& dataIDs) {
+  NS_LOG_FUNCTION(this);
+
+  // every item gets its own request ID so they are answered and time out separately
+  uint32_t reqID = GenMessageID(dataIDs.size());
+
+  SafHeader send;
+  send.SetReplication(true);
+  send.SetTimestamp(Simulator::Now().GetMilliSeconds());
+  send.SetId(reqID);
+
+  for (uint16_t i = 0; i < dataIDs.size(); i++) {
+    send.AddItem(dataIDs[i], i, 0);
+    TrackRequest(reqID + i, dataIDs[i], true, false, 0);
+  }
+  SendRequest(m_codec.Encode(send), Ipv4Address::GetBroadcast());
+
+  NS_LOG_INFO(
+      "At time " << Simulator::Now().GetSeconds() << "s sent request for " << dataIDs.size()
+                 << " items");
+}
+
+void SafApplication::TrackRequest(
+    uint32_t reqID,
+    uint16_t dataID,
+    bool isReplication,
+    bool unicast,
+    uint8_t hopLimit) {
+  PendingRequest request;
+  request.requestID = reqID;
+  request.dataID = dataID;
+  request.kind = isReplication ? PendingRequestTable::REALLOCATION : PendingRequestTable::LOOKUP;
+  request.retries = 0;
+  request.waiters = 0;
+  request.unicast = unicast;
+  request.hopLimit = hopLimit;
+  request.sendTime = Simulator::Now();
+  m_pending_requests.Insert(request);  // add to pending list
+
+  // only requests that will time out can have lookups attached to them, otherwise
+  // they would stay in flight for the rest of the simulation if no one answers
+  Time timeout = GetRequestTimeout(hopLimit);
+  bool expires = Simulator::Now() + timeout < m_stopTime;
 
   if (isReplication) {
-    m_pending_reallocations.insert(reqID);  // add to pending list
     // stats for reallocation
-    if (!m_realloc_sent_CB.IsNull()) m_realloc_sent_CB(dataID, GetNode()->GetId());
+    Count(SafStatsSink::REALLOC_SENT, dataID);
 
-    if (Simulator::Now() + m_request_timeout < m_stopTime) {
-      Simulator::Schedule(m_request_timeout, &SafApplication::ReallocationTimeout, this, reqID);
+    if (expires) {
+      m_timeouts.Push(timeout, reqID, request.kind);
     }
   } else {
-    m_pending_lookups.insert(reqID);  // add to pending list
     // stats for 'normal lookup'
-    if (!m_lookup_sent_CB.IsNull()) m_lookup_sent_CB(dataID, GetNode()->GetId());
+    Count(SafStatsSink::LOOKUP_SENT, dataID);
 
-    if (Simulator::Now() + m_request_timeout < m_stopTime) {
-      Simulator::Schedule(m_request_timeout, &SafApplication::LookupTimeout, this, reqID);
+    if (expires) {
+      m_timeouts.Push(timeout, reqID, request.kind);
+      m_inflight_lookups[dataID] = reqID;
     }
   }
+}
 
-  m_socket_send->Send(packet);
-  m_sent++;
+void SafApplication::SendRequest(Ptr<Packet> packet, Ipv4Address destination) {
+  Address localAddress;
+  m_socket_send->GetSockName(localAddress);
 
-  NS_LOG_INFO("At time " << Simulator::Now().GetSeconds() << "s sent request for " << dataID);
+  // call to the trace sinks before the packet is actually sent,
+  // so that tags added to the packet can be sent as well
+  m_txTrace(packet);
+  m_txTraceWithAddresses(packet, localAddress, InetSocketAddress(destination, m_port));
+
+  // TODO: use add a hook to the router to get all of the other one hop nodes in
+  // the routing table to get the total number of recipients
+
+  if (destination.IsBroadcast()) {
+    m_socket_send->Send(packet);
+  } else {
+    m_socket_send->SendTo(packet, 0, InetSocketAddress(destination, m_port));
+  }
+  m_sent++;
 }
 
-void SafApplication::LookupTimeout(uint32_t requestID) {
+void SafApplication::RequestTimeout(uint32_t requestID, uint8_t kind) {
   NS_LOG_FUNCTION(this);
 
-  // check to see if it is still in the pending lookup list
-  std::set<uint32_t>::iterator item = m_pending_lookups.find(requestID);
+  // answered requests have already been removed, so only the unanswered ones are left
+  PendingRequest request;
+  if (!m_pending_requests.Remove(requestID, request)) {
+    return;
+  }
 
-  if (item != m_pending_lookups.end()) {
-    if (!m_lookup_timeout_CB.IsNull()) m_lookup_timeout_CB(requestID, GetNode()->GetId());
-    m_pending_lookups.erase(item);
+  if (request.kind == PendingRequestTable::REALLOCATION) {
+    Count(SafStatsSink::REALLOC_TIMEOUT, request.dataID);
+  } else if (request.unicast) {
+    // the cached holder did not answer, it may have moved away or evicted the item
+    m_location_cache.Forget(request.dataID);
+    ReleaseLookup(request);
+    RetryAsBroadcast(request, GetFirstRing());
+  } else if (request.hopLimit > 0 && request.hopLimit < m_max_hops) {
+    // expanding ring, the next attempt reaches twice as far
+    ReleaseLookup(request);
+    RetryAsBroadcast(request, std::min<uint32_t>(2 * request.hopLimit, m_max_hops));
+  } else {
+    ReleaseLookup(request);
+    Count(SafStatsSink::LOOKUP_TIMEOUT, request.dataID);
   }
 }
 
-void SafApplication::ReallocationTimeout(uint32_t requestID) {
+uint32_t SafApplication::GetReplicaRank(uint16_t dataID) const {
+  uint32_t rank = m_catalog->GetRank(dataID);
+  return m_wanted_replicas.Contains(dataID) ? rank : rank + m_total_data_items;
+}
+
+void SafApplication::UpdateWantedReplicas() {
   NS_LOG_FUNCTION(this);
 
-  // check to see if it is still in the pending lookup list
-  std::set<uint32_t>::iterator item = m_pending_reallocations.find(requestID);
+  // the stored replicas keep the missing set and their ranks up to date, so
+  // both only have to be rebuilt when the allocation changed
+  if (!m_allocation_policy->Allocate(m_allocation_member, m_wanted_replicas)) {
+    return;
+  }
+
+  m_missing_replicas.Clear();
+  const std::vector<uint16_t>& wanted = m_wanted_replicas.GetMembers();
+  for (size_t i = 0; i < wanted.size(); i++) {
+    if (!m_replica_data_items.Contains(wanted[i])) {
+      m_missing_replicas.Insert(wanted[i]);
+    }
+  }
 
-  if (item != m_pending_reallocations.end()) {
-    if (!m_realloc_timeout_CB.IsNull()) m_realloc_timeout_CB(requestID, GetNode()->GetId());
-    m_pending_reallocations.erase(item);
+  // replicas that are no longer wanted are the first to make room for the new ones
+  m_replica_ranks.Clear();
+  for (DataStore::Iterator it = m_replica_data_items.Begin(); it != m_replica_data_items.End();
+       ++it) {
+    m_replica_ranks.Insert(it->GetDataID(), GetReplicaRank(it->GetDataID()));
   }
 }
 
 void SafApplication::RunReplication() {
   NS_LOG_FUNCTION(this);
 
-  // check if all the items are stored
-  if (m_replica_data_items.size() == m_replica_space) {
-    return;
-  }
-
-  // check to see which items are not yet found, and request them if necessary
-  for (uint16_t i = 0; i < m_replica_space; i++) {
-    bool found = false;
-    for (std::vector<Data>::iterator it = m_replica_data_items.begin();
-         it != m_replica_data_items.end();
-         ++it) {
-      if ((*it).GetStatus() == DataStatus::stored &&
-          (*it).GetDataID() == m_access_frequencies[i][0]) {
-        found = true;
-        break;
+  UpdateWantedReplicas();
+
+  // only the wanted replicas that are not stored yet are requested, a full
+  // store still makes room for them by evicting the replicas that are not wanted
+  const std::vector<uint16_t>& missing = m_missing_replicas.GetMembers();
+  if (!missing.empty()) {
+    if (m_batch_replication) {
+      AskPeers(missing);
+    } else {
+      for (size_t i = 0; i < missing.size(); i++) {
+        AskPeers(missing[i], true);
       }
     }
-
-    if (!found) AskPeers(m_access_frequencies[i][0], true);
   }
 
   // schedule next reallocation event
@@ -746,9 +1316,4 @@ void SafApplication::RunReplication() {
       Simulator::Schedule(m_reallocation_period, &SafApplication::RunReplication, this);
 }
 
-// compariator for sorting access frequencies sorts highest to lowest
-bool AccessFrequencyComparator(std::vector<uint16_t> i, std::vector<uint16_t> j) {
-  return i[1] > j[1];
-}
-
 }  // namespace ns3
@@ -2,7 +2,6 @@
 #ifndef SAF_H
 #define SAF_H
 
-#include <set>     // std::set
 #include <vector>  // std::vector
 
 #include "ns3/application.h"
@@ -18,7 +17,21 @@
 #include "ns3/time-data-calculators.h"
 #include "ns3/traced-callback.h"
 
+#include "data-id-set.h"
+#include "data-store.h"
 #include "data.h"
+#include "deadline-queue.h"
+#include "location-cache.h"
+#include "lookup-sampler.h"
+#include "message-id-generator.h"
+#include "pending-request-table.h"
+#include "replica-allocation-policy.h"
+#include "replica-heap.h"
+#include "saf-catalog.h"
+#include "saf-codec.h"
+#include "saf-header.h"
+#include "saf-stats-sink.h"
+#include "seen-request-cache.h"
 
 namespace ns3 {
 
@@ -40,6 +53,27 @@ class SafApplication : public Application {
 
   virtual ~SafApplication();
 
+  /**
+   * How data lookups are scheduled. PER_ITEM keeps one event chain for every
+   * data item, AGGREGATE keeps a single pending event per node that picks the
+   * item to look up in proportion to its access frequency.
+   */
+  enum LookupEngine { PER_ITEM, AGGREGATE };
+
+  /**
+   * TracedCallback signature for the number of bytes copied out of a received packet.
+   *
+   * \param [in] bytes The number of bytes copied.
+   */
+  typedef void (*CopiedBytesTracedCallback)(uint32_t bytes);
+
+  /**
+   * TracedCallback signature for the CPU time spent caching an overheard item.
+   *
+   * \param [in] nanoseconds The wall clock time spent on the item.
+   */
+  typedef void (*OverheardTimeTracedCallback)(int64_t nanoseconds);
+
   /**
    * Get the number of data bytes that will be sent to the server.
    *
@@ -71,6 +105,22 @@ class SafApplication : public Application {
    */
   void SetFill(uint8_t* fill, uint32_t fillSize, uint32_t dataSize);
 
+  /**
+   * Assign fixed random variable stream numbers to the random variables used
+   * by this application.
+   *
+   * \param stream The first stream index to use.
+   * \returns The number of stream indices assigned by this application.
+   */
+  int64_t AssignStreams(int64_t stream);
+
+  /**
+   * Look up a data item right away, outside of the lookup schedule of the node.
+   *
+   * \param dataID The data item to look up.
+   */
+  void LookupData(uint16_t dataID);
+
  protected:
   virtual void DoDispose(void);
 
@@ -89,15 +139,96 @@ class SafApplication : public Application {
 
   void HandleResponse(Ptr<Socket> socket);
 
+  // remember the sender of the response as the holder of its items
+  void LearnLocations(const SafHeader& recvd, const Address& from);
+
+  // rebroadcast a request for an item this node does not hold while it is within its hop limit
+  void ForwardRequest(const SafHeader& request);
+
+  // send a response to a request this node forwarded on to where the request came from,
+  // returns false if the response is not for such a request
+  bool RelayResponse(const SafHeader& response);
+
+  // with onlyPending set the items that are not being waited on are only
+  // cached as overheard items, if that is enabled
+  void ProcessResponse(const SafHeader& recvd, bool onlyPending);
+
+  void ProcessItem(
+      const SafHeader& recvd,
+      uint32_t origID,
+      uint16_t dataID,
+      uint32_t dataSize,
+      bool onlyPending);
+
+  // admit an item from a response to another node if it ranks above a held replica
+  void CacheOverheardItem(uint16_t dataID, uint32_t dataSize);
+
+  // report an event of this node to the stats sink
+  void Count(SafStatsSink::Counter counter, uint16_t dataID);
+  void Record(SafStatsSink::Delay delay, uint16_t dataID, Time value);
+
+  void ReportRequestReceived(uint16_t dataID, bool isReplication);
+
+  bool HoldsRequestedItem(const SafHeader& request) const;
+
+  // builds the response to a request and reports it as sent, 0 if none of the
+  // requested items are held
+  Ptr<Packet> MakeResponse(const SafHeader& request);
+
+  void ReportResponseSent(uint16_t dataID, bool isReplication);
+
+  void SendScheduledResponse(uint32_t requestID);
+
+  // drop the items of the overheard response from the scheduled response to the same
+  // request, the response is only cancelled once someone else sent all of its items
+  void CancelResponse(const SafHeader& response);
+
   void GenerateDataItems();
 
+  // a full store only admits the item by evicting a less frequently accessed replica
   void SaveDataItem(Data data);
 
+  // drop a replica, it is requested again in the next round if it is still wanted
+  void EvictDataItem(uint16_t dataID);
+
   void AskPeers(uint16_t dataID, bool isReplication);
 
-  void LookupData(uint16_t dataID);
+  // a single batched replication request for every item in dataIDs
+  void AskPeers(const std::vector<uint16_t>& dataIDs);
+
+  // send a lookup that was not answered to everyone within hopLimit hops instead
+  void RetryAsBroadcast(const PendingRequest& request, uint8_t hopLimit);
+
+  // the hop limit of the first broadcast of a lookup, 0 if lookups are not forwarded
+  uint8_t GetFirstRing() const;
+
+  // how long a request that peers forward up to hopLimit hops is waited on
+  Time GetRequestTimeout(uint8_t hopLimit) const;
+
+  // add the request to the pending list and report it as sent
+  void TrackRequest(
+      uint32_t reqID,
+      uint16_t dataID,
+      bool isReplication,
+      bool unicast,
+      uint8_t hopLimit);
+
+  void SendRequest(Ptr<Packet> packet, Ipv4Address destination);
+
+  // returns false if there is no pending lookup of the item to attach to
+  bool AttachLookup(uint16_t dataID);
 
-  static uint32_t GenMessageID();
+  // the pending retry of the lookup of the item first sent at askTime, 0 if there is none
+  uint32_t FindRetry(uint16_t dataID, uint32_t askTime) const;
+
+  // stop attaching lookups to the request once it has been answered or timed out
+  void ReleaseLookup(const PendingRequest& request);
+
+  // reserves count consecutive IDs that are not in use and returns the first one
+  uint32_t GenMessageID(uint16_t count = 1);
+
+  // true if any of the count IDs from first is pending or seen
+  bool IsMessageIDInUse(uint32_t first, uint16_t count) const;
 
   uint32_t m_size;  //!< Size of the sent packet
 
@@ -111,18 +242,54 @@ class SafApplication : public Application {
 
   EventId m_reallocation_event;  // for pending reallocation events
 
-  std::vector<Data> m_replica_data_items;    // the block of memory to hold the data items
-  std::vector<Data> m_origianal_data_items;  // the block of memory to hold the
-                                             // originals data items
+  DataStore m_replica_data_items;    // the replicas held by this node
+  ReplicaHeap m_replica_ranks;       // the same replicas, the first to be evicted on top
+  DataStore m_origianal_data_items;  // the originals data items owned by this node
+
+  DataIdSet m_wanted_replicas;   // the replicas this node should hold
+  DataIdSet m_missing_replicas;  // the wanted replicas that are not stored yet
+
+  ReplicaAllocationPolicy::Scheme m_replica_allocation;
+  Ptr<ReplicaAllocationPolicy> m_allocation_policy;  // decides the wanted replicas
+  uint32_t m_allocation_member;                      // this node in the allocation policy
+  double m_neighbor_range;
+
+  Ptr<SafCatalog> m_catalog;  // the access frequencies and ranking of the data items
+  PendingRequestTable m_pending_requests;  // lookups and reallocations waiting on a response
+
+  // data ID -> the pending lookup request for it, 0 if there is none
+  std::vector<uint32_t> m_inflight_lookups;
+  bool m_coalesce_lookups;
+
+  LocationCache m_location_cache;  // the last known holders of data items
+  uint16_t m_location_cache_size;
+  ns3::Time m_location_cache_lifetime;
 
-  std::vector<std::vector<uint16_t>> m_access_frequencies;
-  std::set<uint32_t> m_pending_lookups;
-  std::set<uint32_t> m_pending_reallocations;
+  uint8_t m_max_hops;                // lookups are forwarded by peers when above 1
+  SeenRequestCache m_seen_requests;  // multi-hop requests seen and the way back to their sender
+
+  // a response waiting out its backoff before being broadcast
+  struct ScheduledResponse {
+    SafHeader request;
+    EventId event;
+  };
+
+  bool m_batch_replication;
+
+  bool m_broadcast_responses;
+  bool m_cache_overheard;
+  DataIdSet m_overheard_items;  // replicas that were admitted from overheard responses
+
+  bool m_response_suppression;
+  ns3::Time m_suppression_backoff;
+  Ptr<UniformRandomVariable> m_backoff;
+  std::vector<ScheduledResponse> m_scheduled_responses;  // only a handful at any time
 
-  // uint16_t* m_access_frequencies; // since the access frequencies are static
-  // and known for all data items
   uint16_t m_total_data_items;
   uint32_t m_total_num_nodes;
+  uint32_t m_node_index;  // picks the original data items and message IDs of the node
+
+  MessageIdGenerator m_message_ids;
 
   uint16_t m_origianal_space;  // the number of data items that can be stored by
                                // the node
@@ -133,19 +300,44 @@ class SafApplication : public Application {
   double m_standard_deviation;
 
   ns3::Time m_request_timeout;
+  ns3::Time m_timeout_resolution;
   ns3::Time m_reallocation_period;
 
   bool m_running;
 
-  std::vector<Ptr<ExponentialRandomVariable>> m_data_lookup_generator;
+  SafCodec::WireFormat m_wire_format;
+  SafCodec m_codec;  // encodes and decodes every packet sent and received
+
+  LookupEngine m_lookup_engine;
+
+  // every lookup delay and AGGREGATE pick is drawn from this one stream
+  Ptr<UniformRandomVariable> m_lookup_stream;
+
+  // draws the access frequencies of access frequency mode 3
+  Ptr<NormalRandomVariable> m_frequency_stream;
 
-  double CalculateAccessFrequency(uint16_t dataID);
+  // used when using AGGREGATE lookups
+  LookupSampler m_lookup_sampler;
+  EventId m_lookup_event;
 
-  Data GetDataItem(uint16_t dataID);
+  // an exponentially distributed delay with the given mean, from m_lookup_stream
+  double DrawExponential(double mean);
 
-  void LookupTimeout(uint32_t requestID);
+  // returns 0 if the item is not held by this node
+  const Data* GetDataItem(uint16_t dataID) const;
 
-  void ReallocationTimeout(uint32_t requestID);
+  // like GetDataItem, but also returns 0 if the item is not stored yet
+  const Data* GetStoredItem(uint16_t dataID) const;
+
+  DeadlineQueue m_timeouts;  // pending request timeouts, only the earliest is scheduled
+
+  void RequestTimeout(uint32_t requestID, uint8_t kind);
+
+  // wanted replicas rank above every other item, then by access frequency
+  uint32_t GetReplicaRank(uint16_t dataID) const;
+
+  // ask the allocation policy for the replicas to hold this period
+  void UpdateWantedReplicas();
 
   void RunReplication();
 
@@ -153,12 +345,22 @@ class SafApplication : public Application {
 
   void ScheduleNextLookup(uint16_t dataID);
 
+  void ScheduleAggregateLookup();
+
+  void RunAggregateLookup();
+
   /// Callbacks for tracing the packet Tx events
   TracedCallback<Ptr<const Packet>> m_txTrace;
 
   /// Callbacks for tracing the packet Rx events
   TracedCallback<Ptr<const Packet>> m_rxTrace;
 
+  /// Callbacks for tracing the number of bytes copied for each received packet
+  TracedCallback<uint32_t> m_rxCopiedTrace;
+
+  /// Callbacks for tracing the time spent on each overheard item
+  TracedCallback<int64_t> m_overheardTimeTrace;
+
   /// Callbacks for tracing the packet Tx events, includes source and
   /// destination addresses
   TracedCallback<Ptr<const Packet>, const Address&, const Address&> m_txTraceWithAddresses;
@@ -167,20 +369,7 @@ class SafApplication : public Application {
   /// destination addresses
   TracedCallback<Ptr<const Packet>, const Address&, const Address&> m_rxTraceWithAddresses;
 
-  Callback<void, uint16_t, uint32_t> m_cache_hit_CB;
-  Callback<void, uint16_t, uint32_t> m_lookup_sent_CB;
-  Callback<void, uint16_t, uint32_t> m_lookup_rcv_CB;
-  Callback<void, uint16_t, uint32_t> m_lookup_rsp_sent_CB;
-  Callback<void, uint32_t, uint32_t> m_lookup_timeout_CB;
-  Callback<void, uint32_t, uint32_t> m_realloc_timeout_CB;
-  Callback<void, uint16_t, uint32_t> m_realloc_sent_CB;
-  Callback<void, uint16_t, uint32_t> m_realloc_rcv_CB;
-  Callback<void, uint16_t, uint32_t> m_realloc_rsp_sent_CB;
-
-  Callback<void, uint16_t, uint32_t, ns3::Time> m_lookup_ontime_CB;
-  Callback<void, uint16_t, uint32_t, ns3::Time> m_lookup_late_CB;
-  Callback<void, uint16_t, uint32_t, ns3::Time> m_realloc_ontime_CB;
-  Callback<void, uint16_t, uint32_t, ns3::Time> m_realloc_late_CB;
+  Ptr<SafStatsSink> m_stats;  // 0 when no statistics are kept
 };
 }  // namespace ns3
 
@@ -0,0 +1,75 @@
+
+#include "seen-request-cache.h"
+
+namespace ns3 {
+
+SeenRequestCache::SeenRequestCache() {
+  m_next = 0;
+  m_size = 0;
+}
+
+SeenRequestCache::~SeenRequestCache() {}
+
+void SeenRequestCache::Init(uint32_t capacity) {
+  m_ring.assign(capacity, Entry());
+  m_index.clear();
+  m_index.reserve(capacity);
+  m_next = 0;
+  m_size = 0;
+}
+
+bool SeenRequestCache::Insert(uint32_t requestID, const Address& from, Time now) {
+  if (Contains(requestID)) {
+    return false;
+  }
+  if (m_ring.empty()) {
+    return true;
+  }
+
+  Entry& entry = m_ring[m_next];
+  if (m_size == m_ring.size()) {
+    m_index.erase(entry.requestID);
+  } else {
+    m_size++;
+  }
+
+  entry.requestID = requestID;
+  entry.from = from;
+  entry.seen = now;
+  m_index[requestID] = m_next;
+  m_next = (m_next + 1) % m_ring.size();
+  return true;
+}
+
+bool SeenRequestCache::Contains(uint32_t requestID) const {
+  return m_index.find(requestID) != m_index.end();
+}
+
+bool SeenRequestCache::TakeRoute(uint32_t requestID, Time notBefore, Address& from) {
+  std::unordered_map<uint32_t, uint32_t>::const_iterator it = m_index.find(requestID);
+  if (it == m_index.end()) {
+    return false;
+  }
+
+  Entry& entry = m_ring[it->second];
+  if (entry.seen < notBefore || entry.from.IsInvalid()) {
+    return false;
+  }
+
+  // the request stays seen, only the way back is used up
+  from = entry.from;
+  entry.from = Address();
+  return true;
+}
+
+void SeenRequestCache::Clear() {
+  m_index.clear();
+  m_next = 0;
+  m_size = 0;
+}
+
+uint32_t SeenRequestCache::GetSize() const { return m_size; }
+
+uint32_t SeenRequestCache::GetCapacity() const { return m_ring.size(); }
+
+}  // namespace ns3
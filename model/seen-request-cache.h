@@ -0,0 +1,68 @@
+#ifndef SAF_SEEN_REQUEST_CACHE_H
+#define SAF_SEEN_REQUEST_CACHE_H
+
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+#include "ns3/address.h"
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+/**
+ * \brief The multi-hop requests a node has seen, and where they came from.
+ *
+ * Request IDs are unique over the whole simulation, so a request that shows
+ * up a second time is a copy that took another path and is dropped. The
+ * neighbor a request first came from is the way back to the requester, so
+ * responses are relayed to it, at most once per request.
+ *
+ * Holds the last capacity requests in a ring, the oldest one is forgotten to
+ * make room for a new one, so the memory used stays fixed no matter how long
+ * the simulation runs.
+ */
+class SeenRequestCache {
+ public:
+  SeenRequestCache();
+  ~SeenRequestCache();
+
+  // drops every request and makes room for capacity of them
+  void Init(uint32_t capacity);
+
+  // returns false if the request was already seen, otherwise remembers the neighbor it came from
+  bool Insert(uint32_t requestID, const Address& from, Time now);
+
+  bool Contains(uint32_t requestID) const;
+
+  /**
+   * Get the neighbor to relay a response to the request to.
+   *
+   * \param requestID The request the response is for.
+   * \param notBefore Requests seen before this have timed out at the requester.
+   * \param from Set to the neighbor the request came from.
+   * \returns false if the request is unknown, too old, or the route was already taken.
+   */
+  bool TakeRoute(uint32_t requestID, Time notBefore, Address& from);
+
+  void Clear();
+
+  uint32_t GetSize() const;
+  uint32_t GetCapacity() const;
+
+ private:
+  struct Entry {
+    uint32_t requestID;
+    Address from;  // invalid for the requests of this node, they are not relayed
+    Time seen;
+  };
+
+  std::vector<Entry> m_ring;
+  uint32_t m_next;  // the slot the next request goes into
+  uint32_t m_size;
+  std::unordered_map<uint32_t, uint32_t> m_index;  // request ID -> slot
+};
+
+}  // namespace ns3
+
+#endif /* SAF_SEEN_REQUEST_CACHE_H */
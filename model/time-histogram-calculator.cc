@@ -0,0 +1,146 @@
+
+#include <math.h>  // ceil
+
+#include "time-histogram-calculator.h"
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED(TimeHistogramCalculator);
+
+// every power of two is split into 2^SUB_BITS buckets
+static const uint32_t SUB_BITS = 4;
+static const uint32_t SUB_BUCKETS = 1 << SUB_BITS;
+
+// values below SUB_BUCKETS get a bucket each, then every power of two up to 2^63 gets SUB_BUCKETS
+static const uint32_t NUM_BUCKETS = SUB_BUCKETS + (64 - SUB_BITS) * SUB_BUCKETS;
+
+TypeId TimeHistogramCalculator::GetTypeId(void) {
+  static TypeId tid = TypeId("ns3::TimeHistogramCalculator")
+                          .SetParent<DataCalculator>()
+                          .SetGroupName("Stats")
+                          .AddConstructor<TimeHistogramCalculator>();
+  return tid;
+}
+
+TimeHistogramCalculator::TimeHistogramCalculator() {
+  m_buckets.assign(NUM_BUCKETS, 0);
+  m_count = 0;
+}
+
+TimeHistogramCalculator::~TimeHistogramCalculator() {}
+
+void TimeHistogramCalculator::DoDispose(void) { DataCalculator::DoDispose(); }
+
+uint32_t TimeHistogramCalculator::GetBucket(uint64_t value) {
+  if (value < SUB_BUCKETS) {
+    return value;
+  }
+
+  // the position of the highest set bit picks the power of two, the bits below
+  // it pick the sub bucket
+  uint32_t exponent = 63 - __builtin_clzll(value);
+  uint32_t shift = exponent - SUB_BITS;
+  return SUB_BUCKETS + shift * SUB_BUCKETS + ((value >> shift) - SUB_BUCKETS);
+}
+
+uint64_t TimeHistogramCalculator::GetLowest(uint32_t bucket) {
+  if (bucket < SUB_BUCKETS) {
+    return bucket;
+  }
+
+  uint32_t shift = (bucket - SUB_BUCKETS) / SUB_BUCKETS;
+  uint64_t mantissa = SUB_BUCKETS + (bucket - SUB_BUCKETS) % SUB_BUCKETS;
+  return mantissa << shift;
+}
+
+uint64_t TimeHistogramCalculator::GetHighest(uint32_t bucket) {
+  if (bucket + 1 == NUM_BUCKETS) {
+    return UINT64_MAX;
+  }
+  return GetLowest(bucket + 1) - 1;
+}
+
+void TimeHistogramCalculator::Update(const Time i) {
+  if (!m_enabled) {
+    return;
+  }
+
+  int64_t steps = i.GetTimeStep();
+  m_buckets[GetBucket(steps > 0 ? steps : 0)]++;
+
+  if (m_count == 0 || i < m_min) {
+    m_min = i;
+  }
+  if (m_count == 0 || i > m_max) {
+    m_max = i;
+  }
+  m_total += i;
+  m_count++;
+}
+
+void TimeHistogramCalculator::Reset() {
+  m_buckets.assign(NUM_BUCKETS, 0);
+  m_count = 0;
+  m_total = Time();
+  m_min = Time();
+  m_max = Time();
+}
+
+uint64_t TimeHistogramCalculator::GetCount() const { return m_count; }
+
+Time TimeHistogramCalculator::GetTotal() const { return m_total; }
+
+Time TimeHistogramCalculator::GetMin() const { return m_min; }
+
+Time TimeHistogramCalculator::GetMax() const { return m_max; }
+
+Time TimeHistogramCalculator::GetPercentile(double p) const {
+  if (m_count == 0) {
+    return Time();
+  }
+
+  // the rank of the sample at the percentile, counting from 1
+  uint64_t rank = ceil(p * m_count);
+  if (rank <= 1) {
+    return m_min;
+  }
+  if (rank >= m_count) {
+    return m_max;
+  }
+
+  uint64_t seen = 0;
+  uint32_t bucket = 0;
+  while (seen + m_buckets[bucket] < rank) {
+    seen += m_buckets[bucket];
+    bucket++;
+  }
+
+  // the middle of the bucket, but never outside of the samples that were seen
+  uint64_t low = GetLowest(bucket);
+  Time value = TimeStep(low + (GetHighest(bucket) - low) / 2);
+  if (value < m_min) {
+    return m_min;
+  }
+  if (value > m_max) {
+    return m_max;
+  }
+  return value;
+}
+
+void TimeHistogramCalculator::Output(DataOutputCallback& callback) const {
+  callback.OutputSingleton(m_context, m_key + "-count", (uint32_t)m_count);
+  if (m_count == 0) {
+    return;
+  }
+
+  callback.OutputSingleton(m_context, m_key + "-total", m_total);
+  callback.OutputSingleton(m_context, m_key + "-average", Time(m_total / m_count));
+  callback.OutputSingleton(m_context, m_key + "-max", m_max);
+  callback.OutputSingleton(m_context, m_key + "-min", m_min);
+  callback.OutputSingleton(m_context, m_key + "-p50", GetPercentile(0.5));
+  callback.OutputSingleton(m_context, m_key + "-p90", GetPercentile(0.9));
+  callback.OutputSingleton(m_context, m_key + "-p99", GetPercentile(0.99));
+  callback.OutputSingleton(m_context, m_key + "-p99.9", GetPercentile(0.999));
+}
+
+}  // namespace ns3
@@ -0,0 +1,66 @@
+#ifndef SAF_TIME_HISTOGRAM_CALCULATOR_H
+#define SAF_TIME_HISTOGRAM_CALCULATOR_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "ns3/data-calculator.h"
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+/**
+ * \brief A DataCalculator for delays that also gives their percentiles.
+ *
+ * Outputs the same count, total, average, min and max as
+ * TimeMinMaxAvgTotalCalculator, so it can replace it under the same key, and
+ * adds the p50, p90, p99 and p99.9 delays.
+ *
+ * The samples are counted in log spaced buckets, 16 for every power of two
+ * time steps, so the memory used is fixed no matter how many samples there
+ * are. A percentile is the middle of the bucket it falls into, which is
+ * within about 3% of the exact value; delays under 16 time steps are exact.
+ */
+class TimeHistogramCalculator : public DataCalculator {
+ public:
+  static TypeId GetTypeId(void);
+
+  TimeHistogramCalculator();
+  virtual ~TimeHistogramCalculator();
+
+  // negative delays are counted as 0
+  void Update(const Time i);
+
+  void Reset();
+
+  uint64_t GetCount() const;
+  Time GetTotal() const;
+  Time GetMin() const;
+  Time GetMax() const;
+
+  // the delay that fraction p of the samples do not exceed, 0 if there are none
+  Time GetPercentile(double p) const;
+
+  virtual void Output(DataOutputCallback& callback) const;
+
+ protected:
+  virtual void DoDispose(void);
+
+ private:
+  // the bucket counting a delay of value time steps
+  static uint32_t GetBucket(uint64_t value);
+
+  // the smallest and largest delay counted by a bucket
+  static uint64_t GetLowest(uint32_t bucket);
+  static uint64_t GetHighest(uint32_t bucket);
+
+  std::vector<uint64_t> m_buckets;
+  uint64_t m_count;
+  Time m_total;
+  Time m_min;
+  Time m_max;
+};
+
+}  // namespace ns3
+
+#endif /* SAF_TIME_HISTOGRAM_CALCULATOR_H */
@@ -1,7 +1,42 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 
 // Include a header file from your module to test.
+#include "ns3/boolean.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/data-id-set.h"
+#include "ns3/data-store.h"
+#include "ns3/deadline-queue.h"
+#include "ns3/double.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-generator.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/item-counter-matrix.h"
+#include "ns3/location-cache.h"
+#include "ns3/lookup-sampler.h"
+#include "ns3/message-id-generator.h"
+#include "ns3/pending-request-table.h"
+#include "ns3/pointer.h"
+#include "ns3/replica-allocation-policy.h"
+#include "ns3/replica-heap.h"
+#include "ns3/saf-catalog.h"
+#include "ns3/saf-codec.h"
+#include "ns3/saf-header.h"
+#include "ns3/saf-helper.h"
+#include "ns3/saf-stats-sampler.h"
+#include "ns3/saf-stats-sink.h"
 #include "ns3/saf.h"
+#include "ns3/seen-request-cache.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simulator.h"
+#include "ns3/time-histogram-calculator.h"
+#include "ns3/uinteger.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
 
 // An essential include is test.h
 #include "ns3/test.h"
@@ -38,6 +73,1386 @@ void SafTestCase1::DoRun(void) {
   NS_TEST_ASSERT_MSG_EQ_TOL(0.01, 0.01, 0.001, "Numbers are not equal within tolerance");
 }
 
+// Checks the ID indexed lookups of the per node data store
+class DataStoreTestCase : public TestCase {
+ public:
+  DataStoreTestCase();
+  virtual ~DataStoreTestCase();
+
+ private:
+  virtual void DoRun(void);
+};
+
+DataStoreTestCase::DataStoreTestCase() : TestCase("Data store membership and removal") {}
+
+DataStoreTestCase::~DataStoreTestCase() {}
+
+void DataStoreTestCase::DoRun(void) {
+  DataStore store;
+  store.Init(10, 3);
+
+  NS_TEST_ASSERT_MSG_EQ(store.Contains(4), false, "empty store should not hold anything");
+  NS_TEST_ASSERT_MSG_EQ(store.Add(Data(4, 30)), true, "item should fit in the store");
+  NS_TEST_ASSERT_MSG_EQ(store.Add(Data(4, 30)), false, "duplicate items should be rejected");
+  NS_TEST_ASSERT_MSG_EQ(store.Add(Data(7, 30)), true, "item should fit in the store");
+  NS_TEST_ASSERT_MSG_EQ(store.Add(Data(10, 30)), true, "item should fit in the store");
+  NS_TEST_ASSERT_MSG_EQ(store.IsFull(), true, "store should be full");
+  NS_TEST_ASSERT_MSG_EQ(store.Add(Data(1, 30)), false, "full store should reject items");
+
+  NS_TEST_ASSERT_MSG_EQ(
+      (store.GetStatus(7) == DataStatus::stored),
+      true,
+      "stored item should be reported as stored");
+  NS_TEST_ASSERT_MSG_EQ(
+      (store.GetStatus(1) == DataStatus::unknown),
+      true,
+      "missing item should be reported as unknown");
+
+  // removing from the front moves the last item into its slot
+  NS_TEST_ASSERT_MSG_EQ(store.Remove(4), true, "stored item should be removed");
+  NS_TEST_ASSERT_MSG_EQ(store.Remove(4), false, "item should only be removed once");
+  NS_TEST_ASSERT_MSG_EQ(store.GetSize(), 2, "store should hold two items");
+  NS_TEST_ASSERT_MSG_NE(store.Find(10), 0, "moved item should still be found");
+  NS_TEST_ASSERT_MSG_EQ(store.Find(10)->GetDataID(), 10, "moved item should keep its ID");
+  NS_TEST_ASSERT_MSG_EQ(store.Contains(200), false, "out of range IDs are never stored");
+}
+
+// Checks the set used to track the missing replicas
+class DataIdSetTestCase : public TestCase {
+ public:
+  DataIdSetTestCase();
+  virtual ~DataIdSetTestCase();
+
+ private:
+  virtual void DoRun(void);
+};
+
+DataIdSetTestCase::DataIdSetTestCase() : TestCase("Data ID set membership") {}
+
+DataIdSetTestCase::~DataIdSetTestCase() {}
+
+void DataIdSetTestCase::DoRun(void) {
+  DataIdSet set;
+  set.Init(10);
+
+  NS_TEST_ASSERT_MSG_EQ(set.IsEmpty(), true, "new set should be empty");
+  NS_TEST_ASSERT_MSG_EQ(set.Insert(3), true, "new member should be inserted");
+  NS_TEST_ASSERT_MSG_EQ(set.Insert(3), false, "members should only be inserted once");
+  NS_TEST_ASSERT_MSG_EQ(set.Insert(10), true, "new member should be inserted");
+  NS_TEST_ASSERT_MSG_EQ(set.Insert(7), true, "new member should be inserted");
+
+  // erasing from the front moves the last member into its slot
+  NS_TEST_ASSERT_MSG_EQ(set.Erase(3), true, "member should be erased");
+  NS_TEST_ASSERT_MSG_EQ(set.Erase(3), false, "member should only be erased once");
+  NS_TEST_ASSERT_MSG_EQ(set.Contains(7), true, "moved member should still be found");
+  NS_TEST_ASSERT_MSG_EQ(set.Contains(10), true, "other members should still be found");
+  NS_TEST_ASSERT_MSG_EQ(set.GetMembers().size(), 2, "two members should be left");
+  NS_TEST_ASSERT_MSG_EQ(set.Contains(200), false, "out of range IDs are never members");
+
+  set.Clear();
+  NS_TEST_ASSERT_MSG_EQ(set.IsEmpty(), true, "cleared set should be empty");
+  NS_TEST_ASSERT_MSG_EQ(set.Contains(7), false, "cleared set should be empty");
+}
+
+// Checks that the replica heap always has the worst ranked replica on top
+class ReplicaHeapTestCase : public TestCase {
+ public:
+  ReplicaHeapTestCase();
+  virtual ~ReplicaHeapTestCase();
+
+ private:
+  virtual void DoRun(void);
+};
+
+ReplicaHeapTestCase::ReplicaHeapTestCase() : TestCase("Replica heap eviction order") {}
+
+ReplicaHeapTestCase::~ReplicaHeapTestCase() {}
+
+void ReplicaHeapTestCase::DoRun(void) {
+  ReplicaHeap heap;
+  heap.Init(10);
+
+  // the rank of data ID i is 10 - i, so data ID 1 is the least frequently accessed
+  for (uint16_t dataID = 4; dataID <= 9; dataID++) {
+    NS_TEST_ASSERT_MSG_EQ(heap.Insert(dataID, 10 - dataID), true, "new member should be inserted");
+  }
+  NS_TEST_ASSERT_MSG_EQ(heap.Insert(6, 4), false, "members should only be inserted once");
+  NS_TEST_ASSERT_MSG_EQ(heap.GetLowest(), 4, "the worst ranked member should be on top");
+  NS_TEST_ASSERT_MSG_EQ(heap.GetLowestRank(), 6, "the rank of the top should be kept");
+
+  heap.Insert(2, 8);
+  NS_TEST_ASSERT_MSG_EQ(heap.GetLowest(), 2, "a worse ranked member should move to the top");
+
+  // removing from the middle keeps the order of the rest
+  NS_TEST_ASSERT_MSG_EQ(heap.Remove(7), true, "member should be removed");
+  NS_TEST_ASSERT_MSG_EQ(heap.Remove(7), false, "member should only be removed once");
+  uint16_t expected[] = {2, 4, 5, 6, 8, 9};
+  for (uint16_t i = 0; i < 6; i++) {
+    NS_TEST_ASSERT_MSG_EQ(heap.GetLowest(), expected[i], "members should leave worst first");
+    heap.Remove(heap.GetLowest());
+  }
+  NS_TEST_ASSERT_MSG_EQ(heap.IsEmpty(), true, "every member should be removed");
+
+  heap.Insert(3, 7);
+  heap.Clear();
+  NS_TEST_ASSERT_MSG_EQ(heap.Contains(3), false, "cleared heap should be empty");
+}
+
+// Checks that the location cache expires and evicts the holders it learned
+class LocationCacheTestCase : public TestCase {
+ public:
+  LocationCacheTestCase();
+  virtual ~LocationCacheTestCase();
+
+ private:
+  virtual void DoRun(void);
+};
+
+LocationCacheTestCase::LocationCacheTestCase() : TestCase("Location cache holders") {}
+
+LocationCacheTestCase::~LocationCacheTestCase() {}
+
+void LocationCacheTestCase::DoRun(void) {
+  LocationCache cache;
+  cache.Init(10, 2);
+
+  Ipv4Address holder;
+  NS_TEST_ASSERT_MSG_EQ(cache.Lookup(4, Seconds(0), holder), false, "nothing is known yet");
+
+  cache.Learn(4, Ipv4Address("10.0.0.1"), Seconds(1));
+  cache.Learn(7, Ipv4Address("10.0.0.2"), Seconds(2));
+  NS_TEST_ASSERT_MSG_EQ(cache.Lookup(4, Seconds(0), holder), true, "holder should be known");
+  NS_TEST_ASSERT_MSG_EQ(holder, Ipv4Address("10.0.0.1"), "holder should match");
+  NS_TEST_ASSERT_MSG_EQ(cache.Lookup(4, Seconds(1.5), holder), false, "old holders expire");
+
+  // relearning moves the item to a new holder and makes it the newest entry
+  cache.Learn(4, Ipv4Address("10.0.0.3"), Seconds(3));
+  cache.Learn(9, Ipv4Address("10.0.0.4"), Seconds(4));
+  NS_TEST_ASSERT_MSG_EQ(cache.GetSize(), 2, "the cache should stay bounded");
+  NS_TEST_ASSERT_MSG_EQ(cache.Lookup(7, Seconds(0), holder), false, "oldest should be evicted");
+  NS_TEST_ASSERT_MSG_EQ(cache.Lookup(4, Seconds(0), holder), true, "relearned should be kept");
+  NS_TEST_ASSERT_MSG_EQ(holder, Ipv4Address("10.0.0.3"), "holder should be updated");
+
+  NS_TEST_ASSERT_MSG_EQ(cache.Forget(4), true, "known holder should be forgotten");
+  NS_TEST_ASSERT_MSG_EQ(cache.Forget(4), false, "holder should only be forgotten once");
+  NS_TEST_ASSERT_MSG_EQ(cache.Lookup(9, Seconds(0), holder), true, "moved entry should be kept");
+
+  LocationCache disabled;
+  disabled.Init(10, 0);
+  disabled.Learn(4, Ipv4Address("10.0.0.1"), Seconds(1));
+  NS_TEST_ASSERT_MSG_EQ(disabled.Lookup(4, Seconds(0), holder), false, "nothing is cached");
+}
+
+// Checks the duplicate suppression and reverse routes of multi-hop requests
+class SeenRequestCacheTestCase : public TestCase {
+ public:
+  SeenRequestCacheTestCase();
+  virtual ~SeenRequestCacheTestCase();
+
+ private:
+  virtual void DoRun(void);
+};
+
+SeenRequestCacheTestCase::SeenRequestCacheTestCase() : TestCase("Seen request cache") {}
+
+SeenRequestCacheTestCase::~SeenRequestCacheTestCase() {}
+
+void SeenRequestCacheTestCase::DoRun(void) {
+  SeenRequestCache cache;
+  cache.Init(2);
+
+  Address neighbor = InetSocketAddress(Ipv4Address("10.0.0.1"), 1000);
+  Address route;
+  NS_TEST_ASSERT_MSG_EQ(cache.Insert(5, neighbor, Seconds(1)), true, "new request is kept");
+  NS_TEST_ASSERT_MSG_EQ(cache.Insert(5, Address(), Seconds(1)), false, "copy should be dropped");
+  NS_TEST_ASSERT_MSG_EQ(cache.TakeRoute(5, Seconds(2), route), false, "old routes expire");
+  NS_TEST_ASSERT_MSG_EQ(cache.TakeRoute(5, Seconds(0), route), true, "route should be known");
+  NS_TEST_ASSERT_MSG_EQ(route, neighbor, "route should lead to the neighbor");
+  NS_TEST_ASSERT_MSG_EQ(cache.TakeRoute(5, Seconds(0), route), false, "route is only used once");
+  NS_TEST_ASSERT_MSG_EQ(cache.Contains(5), true, "request should stay seen");
+
+  // the requests of the node itself are seen but have no route
+  cache.Insert(6, Address(), Seconds(2));
+  NS_TEST_ASSERT_MSG_EQ(cache.TakeRoute(6, Seconds(0), route), false, "own requests are kept");
+
+  cache.Insert(7, neighbor, Seconds(3));
+  NS_TEST_ASSERT_MSG_EQ(cache.GetSize(), 2, "the cache should stay bounded");
+  NS_TEST_ASSERT_MSG_EQ(cache.Contains(5), false, "oldest should be forgotten");
+  NS_TEST_ASSERT_MSG_EQ(cache.Contains(6), true, "newer should be kept");
+  NS_TEST_ASSERT_MSG_EQ(cache.Insert(5, neighbor, Seconds(4)), true, "forgotten is new again");
+}
+
+// Checks the percentiles of the log bucketed delay histogram
+class TimeHistogramCalculatorTestCase : public TestCase {
+ public:
+  TimeHistogramCalculatorTestCase();
+  virtual ~TimeHistogramCalculatorTestCase();
+
+ private:
+  virtual void DoRun(void);
+};
+
+TimeHistogramCalculatorTestCase::TimeHistogramCalculatorTestCase()
+    : TestCase("Delay histogram percentiles") {}
+
+TimeHistogramCalculatorTestCase::~TimeHistogramCalculatorTestCase() {}
+
+void TimeHistogramCalculatorTestCase::DoRun(void) {
+  Ptr<TimeHistogramCalculator> histogram = CreateObject<TimeHistogramCalculator>();
+  NS_TEST_ASSERT_MSG_EQ(histogram->GetPercentile(0.5), Time(), "empty histogram has no delays");
+
+  // 1 to 1000 ms, so every percentile is known exactly
+  for (uint32_t i = 1000; i >= 1; i--) {
+    histogram->Update(MilliSeconds(i));
+  }
+
+  NS_TEST_ASSERT_MSG_EQ(histogram->GetCount(), 1000, "every sample should be counted");
+  NS_TEST_ASSERT_MSG_EQ(histogram->GetMin(), MilliSeconds(1), "min should be exact");
+  NS_TEST_ASSERT_MSG_EQ(histogram->GetMax(), MilliSeconds(1000), "max should be exact");
+
+  double percentiles[] = {0.5, 0.9, 0.99, 0.999};
+  for (double p : percentiles) {
+    double exact = p * 1000;
+    NS_TEST_ASSERT_MSG_EQ_TOL(
+        histogram->GetPercentile(p).GetMilliSeconds(),
+        exact,
+        exact * 0.035,
+        "percentile should be within the bucket precision");
+  }
+  NS_TEST_ASSERT_MSG_EQ(histogram->GetPercentile(1), MilliSeconds(1000), "p100 is the max");
+
+  // a long tail only moves the high percentiles
+  histogram->Reset();
+  for (uint32_t i = 0; i < 999; i++) {
+    histogram->Update(MilliSeconds(10));
+  }
+  histogram->Update(Seconds(30));
+  NS_TEST_ASSERT_MSG_EQ_TOL(
+      histogram->GetPercentile(0.99).GetMilliSeconds(),
+      10,
+      1,
+      "p99 should ignore the tail");
+  NS_TEST_ASSERT_MSG_EQ(histogram->GetPercentile(1), Seconds(30), "the tail should be the max");
+}
+
+// Checks the per node counters of the stats sink and their flushing
+class SafCounterSinkTestCase : public TestCase {
+ public:
+  SafCounterSinkTestCase();
+  virtual ~SafCounterSinkTestCase();
+
+ private:
+  virtual void DoRun(void);
+};
+
+SafCounterSinkTestCase::SafCounterSinkTestCase() : TestCase("Stats sink counters") {}
+
+SafCounterSinkTestCase::~SafCounterSinkTestCase() {}
+
+void SafCounterSinkTestCase::DoRun(void) {
+  Ptr<SafCounterSink> sink = CreateObject<SafCounterSink>();
+  sink->Reserve(2);
+
+  sink->Count(SafStatsSink::LOOKUP_SENT, 1, 0);
+  sink->Count(SafStatsSink::LOOKUP_SENT, 2, 1);
+  sink->Count(SafStatsSink::LOOKUP_SENT, 2, 1);
+  sink->Count(SafStatsSink::CACHE_HIT, 3, 5);  // grows past the reserved nodes
+  sink->Record(SafStatsSink::LOOKUP_ONTIME, 1, 0, MilliSeconds(20));
+
+  NS_TEST_ASSERT_MSG_EQ(sink->GetNNodes(), 6, "the array should grow to the largest node");
+  NS_TEST_ASSERT_MSG_EQ(sink->GetCount(1, SafStatsSink::LOOKUP_SENT), 2, "per node count");
+  NS_TEST_ASSERT_MSG_EQ(sink->GetCount(5, SafStatsSink::LOOKUP_SENT), 0, "other counters are 0");
+  NS_TEST_ASSERT_MSG_EQ(sink->GetTotal(SafStatsSink::LOOKUP_SENT), 3, "total over the nodes");
+  NS_TEST_ASSERT_MSG_EQ(
+      sink->GetDelayCalculator(SafStatsSink::LOOKUP_ONTIME)->GetCount(),
+      1,
+      "delays are recorded right away");
+
+  // the calculators only see the counts once they are flushed, and each count only once
+  Ptr<CounterCalculator<>> sent = sink->GetCounterCalculator(SafStatsSink::LOOKUP_SENT);
+  NS_TEST_ASSERT_MSG_EQ(sent->GetCount(), 0, "nothing is flushed yet");
+  sink->Flush();
+  NS_TEST_ASSERT_MSG_EQ(sent->GetCount(), 3, "the total should be flushed");
+  sink->Count(SafStatsSink::LOOKUP_SENT, 1, 0);
+  sink->Flush();
+  sink->Flush();
+  NS_TEST_ASSERT_MSG_EQ(sent->GetCount(), 4, "only new counts should be flushed");
+  NS_TEST_ASSERT_MSG_EQ(
+      std::string(SafStatsSink::GetCounterName(SafStatsSink::LOOKUP_SENT)),
+      "lookup-sent",
+      "counters keep their output keys");
+
+  // lookup outcomes are broken down by node and item once the matrix is on
+  sink->EnableItemMatrix(4);
+  sink->Count(SafStatsSink::CACHE_HIT, 3, 1);
+  sink->Count(SafStatsSink::LOOKUP_COALESCED, 3, 1);
+  sink->Count(SafStatsSink::LOOKUP_SENT, 3, 1);
+  sink->Count(SafStatsSink::REALLOC_SENT, 3, 1);
+  sink->Record(SafStatsSink::LOOKUP_LATE, 4, 7, Seconds(12));
+
+  const ItemCounterMatrix& matrix = sink->GetItemMatrix();
+  NS_TEST_ASSERT_MSG_EQ(matrix.Get(1, 3, ItemCounterMatrix::HIT), 1, "hit should be counted");
+  NS_TEST_ASSERT_MSG_EQ(matrix.Get(1, 3, ItemCounterMatrix::MISS), 2, "misses include attached");
+  NS_TEST_ASSERT_MSG_EQ(matrix.Get(1, 2, ItemCounterMatrix::HIT), 0, "other items are apart");
+  NS_TEST_ASSERT_MSG_EQ(matrix.Get(7, 4, ItemCounterMatrix::LATE), 1, "late should be counted");
+  NS_TEST_ASSERT_MSG_EQ(matrix.GetNNodes(), 8, "the matrix should grow to the largest node");
+}
+
+// Checks that the message IDs of different nodes never collide
+class MessageIdGeneratorTestCase : public TestCase {
+ public:
+  MessageIdGeneratorTestCase();
+  virtual ~MessageIdGeneratorTestCase();
+
+ private:
+  virtual void DoRun(void);
+};
+
+MessageIdGeneratorTestCase::MessageIdGeneratorTestCase() : TestCase("Per node message IDs") {}
+
+MessageIdGeneratorTestCase::~MessageIdGeneratorTestCase() {}
+
+void MessageIdGeneratorTestCase::DoRun(void) {
+  // 5 nodes need 3 bits, leaving 29 for the counter
+  MessageIdGenerator first;
+  MessageIdGenerator last;
+  first.Init(0, 5);
+  last.Init(4, 5);
+
+  NS_TEST_ASSERT_MSG_EQ(first.Next(), 1, "IDs start at 1");
+  NS_TEST_ASSERT_MSG_EQ(first.Next(3), 2, "a batch starts at the next ID");
+  NS_TEST_ASSERT_MSG_EQ(first.Next(), 5, "a batch reserves all of its IDs");
+  NS_TEST_ASSERT_MSG_EQ(last.Next(), (4u << 29) + 1, "the index is in the high bits");
+
+  // with two bits left the counter runs from 1 to 3 and then starts over
+  MessageIdGenerator wide;
+  wide.Init(1, 0x40000000);
+  NS_TEST_ASSERT_MSG_EQ(wide.Next(), 5, "the index is above the counter");
+  NS_TEST_ASSERT_MSG_EQ(wide.Next(2), 6, "a batch that fits is kept");
+  NS_TEST_ASSERT_MSG_EQ(wide.HasWrapped(), false, "the counter has not run out yet");
+  NS_TEST_ASSERT_MSG_EQ(wide.Next(), 5, "the counter starts over");
+  NS_TEST_ASSERT_MSG_EQ(wide.HasWrapped(), true, "starting over should be reported");
+  NS_TEST_ASSERT_MSG_EQ(wide.Next(2), 6, "batches do not wrap around");
+  NS_TEST_ASSERT_MSG_EQ(wide.Next(2), 5, "a batch that does not fit starts over");
+  NS_TEST_ASSERT_MSG_EQ(wide.GetCapacity(), 3, "the counter holds three IDs");
+  NS_TEST_ASSERT_MSG_EQ(first.GetCapacity(), (1u << 29) - 1, "the rest of the bits count");
+
+  wide.Init(1, 0x40000000);
+  NS_TEST_ASSERT_MSG_EQ(wide.HasWrapped(), false, "Init forgets the wrap");
+
+  first.Init(0, 5);
+  NS_TEST_ASSERT_MSG_EQ(first.Next(), 1, "Init starts over");
+}
+
+// Checks the rows the sampler appends for every interval
+class SafStatsSamplerTestCase : public TestCase {
+ public:
+  SafStatsSamplerTestCase();
+  virtual ~SafStatsSamplerTestCase();
+
+ private:
+  virtual void DoRun(void);
+};
+
+SafStatsSamplerTestCase::SafStatsSamplerTestCase() : TestCase("Stats sampler rows") {}
+
+SafStatsSamplerTestCase::~SafStatsSamplerTestCase() {}
+
+void SafStatsSamplerTestCase::DoRun(void) {
+  Ptr<SafCounterSink> sink = CreateObject<SafCounterSink>();
+  Ptr<SafStatsSampler> sampler = CreateObject<SafStatsSampler>();
+  sampler->SetAttribute("Interval", TimeValue(Seconds(10)));
+
+  // counted before sampling starts, so not in any row
+  sink->Count(SafStatsSink::LOOKUP_SENT, 1, 0);
+
+  std::string path = CreateTempDirFilename("samples.csv");
+  NS_TEST_ASSERT_MSG_EQ(sampler->Start(sink, path), true, "the file should be opened");
+
+  SafStatsSink::Counter hit = SafStatsSink::CACHE_HIT;
+  SafStatsSink::Counter sent = SafStatsSink::LOOKUP_SENT;
+  SafStatsSink::Delay ontime = SafStatsSink::LOOKUP_ONTIME;
+  Simulator::Schedule(Seconds(1), &SafCounterSink::Count, sink, hit, 1, 0);
+  Simulator::Schedule(Seconds(2), &SafCounterSink::Count, sink, sent, 2, 0);
+  Simulator::Schedule(Seconds(3), &SafCounterSink::Count, sink, sent, 3, 1);
+  Simulator::Schedule(Seconds(4), &SafCounterSink::Record, sink, ontime, 2, 0, MilliSeconds(20));
+  Simulator::Schedule(Seconds(12), &SafCounterSink::Count, sink, sent, 2, 1);
+  Simulator::Stop(Seconds(15));
+  Simulator::Run();
+  sampler->Stop();
+  Simulator::Destroy();
+
+  std::ifstream csv(path.c_str());
+  std::string line;
+  std::vector<std::string> lines;
+  while (std::getline(csv, line)) {
+    lines.push_back(line);
+  }
+  NS_TEST_ASSERT_MSG_EQ(lines.size(), 3, "header, a full interval and the open one");
+  NS_TEST_ASSERT_MSG_EQ(lines[0].compare(0, 24, "time,cache-hit,lookup-se"), 0, "header");
+  NS_TEST_ASSERT_MSG_EQ(lines[1].compare(0, 13, "10.000,1,2,0,"), 0, "interval deltas");
+  NS_TEST_ASSERT_MSG_EQ(lines[2].compare(0, 13, "15.000,0,1,0,"), 0, "open interval deltas");
+
+  // a hit and one of two sent lookups answered in time
+  std::string first = lines[1].substr(lines[1].rfind(',') + 1);
+  std::string second = lines[2].substr(lines[2].rfind(',') + 1);
+  NS_TEST_ASSERT_MSG_EQ(first, "0.6667", "accessibility of the first interval");
+  NS_TEST_ASSERT_MSG_EQ(second, "0.0000", "accessibility of the open interval");
+  NS_TEST_ASSERT_MSG_NE(lines[1].find(",1,20.000,"), std::string::npos, "mean delay in ms");
+}
+
+// Checks the saturation and export of the per node and item counters
+class ItemCounterMatrixTestCase : public TestCase {
+ public:
+  ItemCounterMatrixTestCase();
+  virtual ~ItemCounterMatrixTestCase();
+
+ private:
+  virtual void DoRun(void);
+};
+
+ItemCounterMatrixTestCase::ItemCounterMatrixTestCase() : TestCase("Item counter matrix") {}
+
+ItemCounterMatrixTestCase::~ItemCounterMatrixTestCase() {}
+
+void ItemCounterMatrixTestCase::DoRun(void) {
+  ItemCounterMatrix matrix;
+  matrix.Init(2, 3);
+
+  for (uint32_t i = 0; i < 70000; i++) {
+    matrix.Increment(1, 3, ItemCounterMatrix::MISS);
+  }
+  matrix.Increment(0, 1, ItemCounterMatrix::TIMEOUT);
+  NS_TEST_ASSERT_MSG_EQ(matrix.Get(1, 3, ItemCounterMatrix::MISS), 65535, "counters saturate");
+  NS_TEST_ASSERT_MSG_EQ(matrix.Get(0, 1, ItemCounterMatrix::TIMEOUT), 1, "timeout should count");
+
+  // only the cells that counted something are written as rows
+  std::string csvPath = CreateTempDirFilename("item-matrix.csv");
+  NS_TEST_ASSERT_MSG_EQ(matrix.WriteCsv(csvPath), true, "CSV should be written");
+  std::ifstream csv(csvPath.c_str());
+  std::string line;
+  std::vector<std::string> lines;
+  while (std::getline(csv, line)) {
+    lines.push_back(line);
+  }
+  NS_TEST_ASSERT_MSG_EQ(lines.size(), 3, "header and one row per non empty cell");
+  NS_TEST_ASSERT_MSG_EQ(lines[0], "node,data_id,hit,miss,timeout,late", "header should match");
+  NS_TEST_ASSERT_MSG_EQ(lines[1], "0,1,0,0,1,0", "first row should match");
+  NS_TEST_ASSERT_MSG_EQ(lines[2], "1,3,0,65535,0,0", "second row should match");
+
+  // a 20 byte header and then every cell
+  std::string binaryPath = CreateTempDirFilename("item-matrix.bin");
+  NS_TEST_ASSERT_MSG_EQ(matrix.WriteBinary(binaryPath), true, "binary should be written");
+  std::ifstream binary(binaryPath.c_str(), std::ios::binary | std::ios::ate);
+  std::streamoff size = binary.tellg();
+  NS_TEST_ASSERT_MSG_EQ(size, 20 + 2 * 3 * 4 * 2, "every cell should be written");
+}
+
+// Checks the ranking of the shared access frequency catalog
+class SafCatalogTestCase : public TestCase {
+ public:
+  SafCatalogTestCase();
+  virtual ~SafCatalogTestCase();
+
+ private:
+  virtual void DoRun(void);
+};
+
+SafCatalogTestCase::SafCatalogTestCase() : TestCase("Access frequency catalog ranking") {}
+
+SafCatalogTestCase::~SafCatalogTestCase() {}
+
+void SafCatalogTestCase::DoRun(void) {
+  Ptr<SafCatalog> catalog = CreateObject<SafCatalog>();
+  catalog->Init(10, 2, 0.0, Seconds(256));
+
+  // in mode 2 the access frequency grows with the data ID
+  NS_TEST_ASSERT_MSG_EQ(catalog->GetTotalItems(), 10, "every item should be in the catalog");
+  NS_TEST_ASSERT_MSG_EQ_TOL(catalog->GetLookupDelay(4), 230.4, 1e-9, "delay should match");
+  for (uint16_t rank = 0; rank < 10; rank++) {
+    NS_TEST_ASSERT_MSG_EQ(catalog->GetRanked(rank), 10 - rank, "most accessed should rank first");
+    NS_TEST_ASSERT_MSG_EQ(catalog->GetRank(10 - rank), rank, "rank should invert the ranking");
+  }
+
+  NS_TEST_ASSERT_MSG_EQ(catalog->Matches(10, 2, 0.0, Seconds(256)), true, "same config");
+  NS_TEST_ASSERT_MSG_EQ(catalog->Matches(10, 1, 0.0, Seconds(256)), false, "different mode");
+  NS_TEST_ASSERT_MSG_EQ(SafCatalog::IsShareable(1), true, "mode 1 is the same for every node");
+  NS_TEST_ASSERT_MSG_EQ(SafCatalog::IsShareable(3), false, "mode 3 is drawn per node");
+
+  // mode 3 catalogs drawn from the same stream number should be the same
+  Ptr<NormalRandomVariable> first = CreateObject<NormalRandomVariable>();
+  Ptr<NormalRandomVariable> second = CreateObject<NormalRandomVariable>();
+  first->SetStream(7);
+  second->SetStream(7);
+  Ptr<SafCatalog> drawn = CreateObject<SafCatalog>();
+  Ptr<SafCatalog> redrawn = CreateObject<SafCatalog>();
+  drawn->Init(10, 3, 0.1, Seconds(256), first);
+  redrawn->Init(10, 3, 0.1, Seconds(256), second);
+  for (uint16_t i = 1; i <= 10; i++) {
+    NS_TEST_ASSERT_MSG_EQ_TOL(
+        drawn->GetLookupDelay(i),
+        redrawn->GetLookupDelay(i),
+        1e-9,
+        "the same stream should draw the same frequencies");
+  }
+}
+
+// Checks the replicas allocated by SAF, DAFN and DCG for two neighbors and a node out of range
+class ReplicaAllocationPolicyTestCase : public TestCase {
+ public:
+  ReplicaAllocationPolicyTestCase();
+  virtual ~ReplicaAllocationPolicyTestCase();
+
+ private:
+  virtual void DoRun(void);
+
+  // allocate for three nodes at x = 0, 10 and 1000 that own data IDs 1, 2 and 3
+  std::vector<DataIdSet> Allocate(ReplicaAllocationPolicy::Scheme scheme);
+
+  Ptr<ReplicaAllocationPolicy> m_policy;  // the policy of the last Allocate
+  std::vector<Ptr<Node>> m_nodes;         // and its nodes
+};
+
+ReplicaAllocationPolicyTestCase::ReplicaAllocationPolicyTestCase()
+    : TestCase("Replica allocation policies") {}
+
+ReplicaAllocationPolicyTestCase::~ReplicaAllocationPolicyTestCase() {}
+
+std::vector<DataIdSet> ReplicaAllocationPolicyTestCase::Allocate(
+    ReplicaAllocationPolicy::Scheme scheme) {
+  // in mode 2 the access frequency grows with the data ID
+  Ptr<SafCatalog> catalog = CreateObject<SafCatalog>();
+  catalog->Init(6, 2, 0.0, Seconds(256));
+
+  Ptr<ReplicaAllocationPolicy> policy = ReplicaAllocationPolicy::Create(scheme);
+  policy->SetAttribute("Range", DoubleValue(50.0));
+  m_policy = policy;
+  m_nodes.clear();
+
+  double positions[] = {0.0, 10.0, 1000.0};
+  for (uint16_t i = 0; i < 3; i++) {
+    Ptr<Node> node = CreateObject<Node>();
+    Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel>();
+    mobility->SetPosition(Vector(positions[i], 0.0, 0.0));
+    node->AggregateObject(mobility);
+    m_nodes.push_back(node);
+
+    DataStore originals;
+    originals.Init(6, 1);
+    originals.Add(Data(i + 1, 0));
+    policy->AddMember(node, catalog, originals, 2);
+  }
+
+  std::vector<DataIdSet> allocated(3);
+  for (uint32_t i = 0; i < 3; i++) {
+    allocated[i].Init(6);
+    NS_TEST_EXPECT_MSG_EQ(policy->Allocate(i, allocated[i]), true, "first allocation is new");
+  }
+  return allocated;
+}
+
+void ReplicaAllocationPolicyTestCase::DoRun(void) {
+  std::vector<DataIdSet> saf = Allocate(ReplicaAllocationPolicy::SAF);
+  for (uint32_t i = 0; i < 3; i++) {
+    NS_TEST_ASSERT_MSG_EQ(saf[i].GetSize(), 2, "every node should fill its space");
+    NS_TEST_ASSERT_MSG_EQ(saf[i].Contains(6), true, "every node should hold the top item");
+    NS_TEST_ASSERT_MSG_EQ(saf[i].Contains(5), true, "every node should hold the second item");
+  }
+
+  // the neighbors split the top four items between them, the distant node is on its own
+  ReplicaAllocationPolicy::Scheme schemes[] = {
+      ReplicaAllocationPolicy::DAFN,
+      ReplicaAllocationPolicy::DCG};
+  for (uint32_t s = 0; s < 2; s++) {
+    std::vector<DataIdSet> allocated = Allocate(schemes[s]);
+    NS_TEST_ASSERT_MSG_EQ(allocated[0].Contains(6), true, "the first node keeps the top item");
+    NS_TEST_ASSERT_MSG_EQ(allocated[0].Contains(5), true, "the first node keeps the second item");
+    NS_TEST_ASSERT_MSG_EQ(allocated[1].Contains(4), true, "the neighbor takes the next item");
+    NS_TEST_ASSERT_MSG_EQ(allocated[1].Contains(3), true, "the neighbor takes the next item");
+    NS_TEST_ASSERT_MSG_EQ(allocated[2].Contains(6), true, "the distant node holds the top item");
+    NS_TEST_ASSERT_MSG_EQ(allocated[2].Contains(5), true, "the distant node holds the second");
+  }
+
+  // an allocation is only handed out again once it changed, which SAF never does
+  saf = Allocate(ReplicaAllocationPolicy::SAF);
+  Ptr<ReplicaAllocationPolicy> safPolicy = m_policy;
+  std::vector<DataIdSet> dafn = Allocate(ReplicaAllocationPolicy::DAFN);
+  NS_TEST_ASSERT_MSG_EQ(m_policy->Allocate(2, dafn[2]), false, "nothing changed in the period");
+
+  // the distant node moves next to the others by the next period
+  m_nodes[2]->GetObject<MobilityModel>()->SetPosition(Vector(20.0, 0.0, 0.0));
+  Simulator::Stop(Seconds(256));
+  Simulator::Run();
+  NS_TEST_ASSERT_MSG_EQ(m_policy->Allocate(2, dafn[2]), true, "the new neighbors change it");
+  NS_TEST_ASSERT_MSG_EQ(dafn[2].Contains(5), false, "the neighbor holds the second item");
+  NS_TEST_ASSERT_MSG_EQ(safPolicy->Allocate(0, saf[0]), false, "SAF ignores the positions");
+
+  Simulator::Destroy();
+}
+
+// Checks that the aggregate lookup engine picks items in proportion to their rate
+class LookupSamplerTestCase : public TestCase {
+ public:
+  LookupSamplerTestCase();
+  virtual ~LookupSamplerTestCase();
+
+ private:
+  virtual void DoRun(void);
+};
+
+LookupSamplerTestCase::LookupSamplerTestCase() : TestCase("Lookup sampler item selection") {}
+
+LookupSamplerTestCase::~LookupSamplerTestCase() {}
+
+void LookupSamplerTestCase::DoRun(void) {
+  LookupSampler sampler;
+
+  // data ID 2 and 5 are never looked up
+  std::vector<double> means = {1.0, 0.0, 2.0, 4.0, -1.0};
+  sampler.Init(means);
+
+  NS_TEST_ASSERT_MSG_EQ_TOL(sampler.GetTotalRate(), 1.75, 1e-9, "rates should be summed");
+  NS_TEST_ASSERT_MSG_EQ(sampler.Pick(0.0), 1, "the start of the range is the first item");
+  NS_TEST_ASSERT_MSG_EQ(sampler.Pick(1.0), 3, "items without a rate should be skipped");
+  NS_TEST_ASSERT_MSG_EQ(sampler.Pick(1.6), 4, "the end of the range is the last item");
+  NS_TEST_ASSERT_MSG_EQ(sampler.Pick(1.75), 4, "the last item with a rate is picked past the end");
+
+  // sweep u over the range, each item should get a share equal to its share of the rate
+  const uint32_t steps = 70000;
+  std::vector<uint32_t> picks(means.size() + 1, 0);
+  for (uint32_t i = 0; i < steps; i++) {
+    picks[sampler.Pick((i + 0.5) * sampler.GetTotalRate() / steps)]++;
+  }
+  NS_TEST_ASSERT_MSG_EQ(picks[1], 40000, "item 1 should get 4/7 of the lookups");
+  NS_TEST_ASSERT_MSG_EQ(picks[2], 0, "item 2 should never be looked up");
+  NS_TEST_ASSERT_MSG_EQ(picks[3], 20000, "item 3 should get 2/7 of the lookups");
+  NS_TEST_ASSERT_MSG_EQ(picks[4], 10000, "item 4 should get 1/7 of the lookups");
+  NS_TEST_ASSERT_MSG_EQ(picks[5], 0, "item 5 should never be looked up");
+
+  sampler.Init(std::vector<double>(3, 0.0));
+  NS_TEST_ASSERT_MSG_EQ(sampler.GetTotalRate(), 0.0, "nothing should be looked up");
+  NS_TEST_ASSERT_MSG_EQ(sampler.Pick(0.0), 0, "nothing should be picked");
+}
+
+// Checks that request timeouts expire in order and in batches
+class DeadlineQueueTestCase : public TestCase {
+ public:
+  DeadlineQueueTestCase();
+  virtual ~DeadlineQueueTestCase();
+
+ private:
+  virtual void DoRun(void);
+
+  void Expired(uint32_t id, uint8_t kind);
+
+  std::vector<uint32_t> m_ids;
+  std::vector<Time> m_times;
+};
+
+DeadlineQueueTestCase::DeadlineQueueTestCase() : TestCase("Deadline queue expiry") {}
+
+DeadlineQueueTestCase::~DeadlineQueueTestCase() {}
+
+void DeadlineQueueTestCase::Expired(uint32_t id, uint8_t kind) {
+  NS_TEST_EXPECT_MSG_EQ(kind, id % 2, "kind should be passed through");
+  m_ids.push_back(id);
+  m_times.push_back(Simulator::Now());
+}
+
+void DeadlineQueueTestCase::DoRun(void) {
+  DeadlineQueue queue;
+  queue.SetExpireCallback(MakeCallback(&DeadlineQueueTestCase::Expired, this));
+  queue.SetResolution(MilliSeconds(100));
+
+  // 1 and 2 round up to the same deadline, 3 gets its own
+  Simulator::Schedule(MilliSeconds(10), &DeadlineQueue::Push, &queue, Seconds(1), 1, 1);
+  Simulator::Schedule(MilliSeconds(50), &DeadlineQueue::Push, &queue, Seconds(1), 2, 0);
+  Simulator::Schedule(MilliSeconds(150), &DeadlineQueue::Push, &queue, Seconds(1), 3, 1);
+  Simulator::Run();
+  Simulator::Destroy();
+
+  NS_TEST_ASSERT_MSG_EQ(m_ids.size(), 3, "every entry should expire");
+  NS_TEST_ASSERT_MSG_EQ(m_ids[0], 1, "entries should expire in order");
+  NS_TEST_ASSERT_MSG_EQ(m_ids[1], 2, "entries should expire in order");
+  NS_TEST_ASSERT_MSG_EQ(m_ids[2], 3, "entries should expire in order");
+  NS_TEST_ASSERT_MSG_EQ(m_times[0], MilliSeconds(1100), "deadline should be rounded up");
+  NS_TEST_ASSERT_MSG_EQ(m_times[1], MilliSeconds(1100), "close deadlines should expire together");
+  NS_TEST_ASSERT_MSG_EQ(m_times[2], MilliSeconds(1200), "deadline should be rounded up");
+  NS_TEST_ASSERT_MSG_EQ(queue.GetSize(), 0, "the queue should be empty");
+
+  // ring timeouts of a 4 hop search, a wider ring is pushed before a narrower one expires
+  m_ids.clear();
+  m_times.clear();
+  queue.SetResolution(Seconds(0));
+  Simulator::Schedule(Seconds(0), &DeadlineQueue::Push, &queue, Seconds(4), 5, 1);
+  Simulator::Schedule(Seconds(0), &DeadlineQueue::Push, &queue, Seconds(1), 7, 1);
+  Simulator::Schedule(Seconds(0), &DeadlineQueue::Push, &queue, Seconds(2), 6, 0);
+  Simulator::Schedule(Seconds(1), &DeadlineQueue::Push, &queue, Seconds(2), 8, 0);
+  Simulator::Schedule(Seconds(1), &DeadlineQueue::Push, &queue, MilliSeconds(500), 9, 1);
+  Simulator::Run();
+  Simulator::Destroy();
+
+  uint32_t ringIds[] = {7, 9, 6, 8, 5};
+  Time ringTimes[] = {Seconds(1), MilliSeconds(1500), Seconds(2), Seconds(3), Seconds(4)};
+  NS_TEST_ASSERT_MSG_EQ(m_ids.size(), 5, "every ring timeout should expire");
+  for (uint32_t i = 0; i < 5; i++) {
+    NS_TEST_ASSERT_MSG_EQ(m_ids[i], ringIds[i], "shorter timeouts should expire first");
+    NS_TEST_ASSERT_MSG_EQ(m_times[i], ringTimes[i], "timeouts should expire on time");
+  }
+}
+
+// Checks inserting and removing requests from the open addressed pending table
+class PendingRequestTableTestCase : public TestCase {
+ public:
+  PendingRequestTableTestCase();
+  virtual ~PendingRequestTableTestCase();
+
+ private:
+  virtual void DoRun(void);
+};
+
+PendingRequestTableTestCase::PendingRequestTableTestCase()
+    : TestCase("Pending request table insert and remove") {}
+
+PendingRequestTableTestCase::~PendingRequestTableTestCase() {}
+
+void PendingRequestTableTestCase::DoRun(void) {
+  PendingRequestTable table;
+
+  // enough requests to make the table grow a few times
+  for (uint32_t id = 1; id <= 1000; id++) {
+    PendingRequest request = PendingRequest();
+    request.requestID = id;
+    request.dataID = id % 100;
+    request.kind = id % 2;
+    NS_TEST_ASSERT_MSG_EQ(table.Insert(request), true, "new request should be inserted");
+  }
+  NS_TEST_ASSERT_MSG_EQ(table.GetSize(), 1000, "every request should be pending");
+
+  PendingRequest duplicate = PendingRequest();
+  duplicate.requestID = 500;
+  NS_TEST_ASSERT_MSG_EQ(table.Insert(duplicate), false, "duplicate request should be rejected");
+
+  // remove every other request, the rest must still be reachable afterwards
+  PendingRequest removed;
+  for (uint32_t id = 1; id <= 1000; id += 2) {
+    NS_TEST_ASSERT_MSG_EQ(table.Remove(id, removed), true, "pending request should be removed");
+    NS_TEST_ASSERT_MSG_EQ(removed.dataID, id % 100, "removed request should keep its data");
+  }
+  NS_TEST_ASSERT_MSG_EQ(table.Remove(1, removed), false, "request should only be removed once");
+
+  for (uint32_t id = 2; id <= 1000; id += 2) {
+    const PendingRequest* request = table.Find(id);
+    NS_TEST_ASSERT_MSG_NE(request, 0, "remaining request should be found");
+    NS_TEST_ASSERT_MSG_EQ(request->kind, 0, "remaining request should keep its kind");
+  }
+  NS_TEST_ASSERT_MSG_EQ(table.Find(3), 0, "removed request should not be found");
+  NS_TEST_ASSERT_MSG_EQ(table.GetSize(), 500, "half of the requests should be pending");
+
+  table.Clear();
+  NS_TEST_ASSERT_MSG_EQ(table.Find(2), 0, "cleared table should be empty");
+  NS_TEST_ASSERT_MSG_EQ(table.GetSize(), 0, "cleared table should be empty");
+}
+
+static SafHeader MakeMessage(bool response, uint32_t dataSize) {
+  SafHeader message;
+  message.SetId(70001);
+  message.SetTimestamp(123456);
+  message.SetDataID(42);
+  message.SetReplication(true);
+  if (response) {
+    message.SetResponse(true);
+    message.SetResponseTo(69999);
+    message.SetOriginalSentAt(123000);
+    message.SetDataSize(dataSize);
+  }
+  return message;
+}
+
+// Checks that an overheard response only takes its own items out of a batched response
+class SafHeaderTestCase : public TestCase {
+ public:
+  SafHeaderTestCase();
+  virtual ~SafHeaderTestCase();
+
+ private:
+  virtual void DoRun(void);
+};
+
+SafHeaderTestCase::SafHeaderTestCase() : TestCase("Partially suppressed batch") {}
+
+SafHeaderTestCase::~SafHeaderTestCase() {}
+
+void SafHeaderTestCase::DoRun(void) {
+  SafHeader request = MakeMessage(false, 0);
+  request.AddItem(5, 0, 0);
+  request.AddItem(9, 1, 0);
+  request.AddItem(300, 2, 0);
+
+  // another responder only holds one of the requested items and one that is not asked for
+  SafHeader overheard = MakeMessage(true, 0);
+  overheard.AddItem(9, 1, 30);
+  overheard.AddItem(77, 3, 30);
+  NS_TEST_ASSERT_MSG_EQ(overheard.RemoveItem(77), true, "held item should be removed");
+  NS_TEST_ASSERT_MSG_EQ(overheard.GetDataSize(), 30, "removed item should not count");
+
+  uint16_t suppressed = 0;
+  for (uint16_t i = 0; i < overheard.GetItemCount(); i++) {
+    suppressed += request.RemoveItem(overheard.GetItem(i).dataID);
+  }
+  NS_TEST_ASSERT_MSG_EQ(suppressed, 1, "only the overlapping item should be suppressed");
+  NS_TEST_ASSERT_MSG_EQ(request.GetItemCount(), 2, "the other items should still be sent");
+  NS_TEST_ASSERT_MSG_EQ(request.GetItem(0).dataID, 5, "first item should be kept");
+  NS_TEST_ASSERT_MSG_EQ(request.GetItem(1).dataID, 300, "last item should be kept");
+  NS_TEST_ASSERT_MSG_EQ(request.GetItem(1).offset, 2, "kept items should keep their offset");
+  NS_TEST_ASSERT_MSG_EQ(request.RemoveItem(9), false, "item should only be removed once");
+}
+
+// Checks that requests and responses survive encoding in every supported format
+class SafCodecTestCase : public TestCase {
+ public:
+  SafCodecTestCase();
+  virtual ~SafCodecTestCase();
+
+ private:
+  virtual void DoRun(void);
+};
+
+SafCodecTestCase::SafCodecTestCase() : TestCase("Wire format round trip") {}
+
+SafCodecTestCase::~SafCodecTestCase() {}
+
+void SafCodecTestCase::DoRun(void) {
+  SafCodec::WireFormat formats[] = {SafCodec::PROTOBUF, SafCodec::HEADER};
+
+  for (SafCodec::WireFormat format : formats) {
+    if (!SafCodec::IsSupported(format)) {
+      continue;
+    }
+
+    SafCodec codec;
+    codec.SetWireFormat(format);
+    codec.Reserve(1024);
+
+    for (bool response : {false, true}) {
+      SafHeader sent = MakeMessage(response, 1024);
+      SafHeader recvd;
+
+      NS_TEST_ASSERT_MSG_EQ(codec.Decode(codec.Encode(sent), recvd), true, "message should decode");
+      NS_TEST_ASSERT_MSG_EQ(recvd.GetId(), sent.GetId(), "id should match");
+      NS_TEST_ASSERT_MSG_EQ(
+          recvd.GetResponseTo(),
+          sent.GetResponseTo(),
+          "response_to should match");
+      NS_TEST_ASSERT_MSG_EQ(
+          recvd.GetOriginalSentAt(),
+          sent.GetOriginalSentAt(),
+          "original_sent_at should match");
+      NS_TEST_ASSERT_MSG_EQ(recvd.GetTimestamp(), sent.GetTimestamp(), "timestamp should match");
+      NS_TEST_ASSERT_MSG_EQ(recvd.GetDataID(), sent.GetDataID(), "data_id should match");
+      NS_TEST_ASSERT_MSG_EQ(recvd.GetDataSize(), sent.GetDataSize(), "data size should match");
+      NS_TEST_ASSERT_MSG_EQ(recvd.IsResponse(), response, "message type should match");
+      NS_TEST_ASSERT_MSG_EQ(recvd.IsReplication(), true, "replication flag should match");
+    }
+
+    // batched requests only carry data IDs, batched responses also carry sizes
+    SafHeader batch = MakeMessage(false, 0);
+    batch.AddItem(5, 0, 0);
+    batch.AddItem(9, 1, 0);
+    batch.AddItem(300, 2, 0);
+    SafHeader recvdBatch;
+    NS_TEST_ASSERT_MSG_EQ(
+        codec.Decode(codec.Encode(batch), recvdBatch),
+        true,
+        "batch should decode");
+    NS_TEST_ASSERT_MSG_EQ(recvdBatch.IsBatch(), true, "batch flag should be set");
+    NS_TEST_ASSERT_MSG_EQ(recvdBatch.GetItemCount(), 3, "every item should be decoded");
+    NS_TEST_ASSERT_MSG_EQ(recvdBatch.GetItem(2).dataID, 300, "item data ID should match");
+    NS_TEST_ASSERT_MSG_EQ(recvdBatch.GetItem(2).offset, 2, "item offset should match");
+
+    SafHeader reply = MakeMessage(true, 0);
+    reply.AddItem(9, 1, 30);
+    reply.AddItem(300, 2, 40);
+    NS_TEST_ASSERT_MSG_EQ(
+        codec.Decode(codec.Encode(reply), recvdBatch),
+        true,
+        "batch should decode");
+    NS_TEST_ASSERT_MSG_EQ(recvdBatch.GetItemCount(), 2, "every item should be decoded");
+    NS_TEST_ASSERT_MSG_EQ(recvdBatch.GetItem(0).offset, 1, "item offset should match");
+    NS_TEST_ASSERT_MSG_EQ(recvdBatch.GetItem(1).size, 40, "item size should match");
+    NS_TEST_ASSERT_MSG_EQ(recvdBatch.GetDataSize(), 70, "data size should be the sum of the items");
+
+    // forwarded messages carry their hop count before the batched items
+    batch.SetHops(2);
+    batch.SetHopLimit(4);
+    NS_TEST_ASSERT_MSG_EQ(
+        codec.Decode(codec.Encode(batch), recvdBatch),
+        true,
+        "multi-hop batch should decode");
+    NS_TEST_ASSERT_MSG_EQ(recvdBatch.IsMultiHop(), true, "multi-hop flag should be set");
+    NS_TEST_ASSERT_MSG_EQ(recvdBatch.GetHops(), 2, "hops should match");
+    NS_TEST_ASSERT_MSG_EQ(recvdBatch.GetHopLimit(), 4, "hop limit should match");
+    NS_TEST_ASSERT_MSG_EQ(recvdBatch.GetItem(2).dataID, 300, "item data ID should match");
+
+    // a response claiming more data than it carries is rejected
+    SafHeader recvd;
+    Ptr<Packet> truncated = codec.Encode(MakeMessage(true, 1024));
+    truncated->RemoveAtEnd(10);
+    NS_TEST_ASSERT_MSG_EQ(codec.Decode(truncated, recvd), false, "truncated message should fail");
+
+    // a message that last held a batch still decodes a shorter packet
+    NS_TEST_ASSERT_MSG_EQ(
+        codec.Decode(codec.Encode(MakeMessage(false, 0)), recvdBatch),
+        true,
+        "reused message should decode");
+    NS_TEST_ASSERT_MSG_EQ(recvdBatch.IsBatch(), false, "batch flag should be cleared");
+
+    // the items of a batch are part of the header, cutting them off is rejected
+    truncated = codec.Encode(batch);
+    truncated->RemoveAtEnd(3);
+    NS_TEST_ASSERT_MSG_EQ(codec.Decode(truncated, recvd), false, "truncated batch should fail");
+    truncated->RemoveAtEnd(truncated->GetSize() - SafHeader::BASE_SIZE - 1);
+    NS_TEST_ASSERT_MSG_EQ(codec.Decode(truncated, recvd), false, "truncated hops should fail");
+  }
+}
+
+// Runs SafApplications on nodes that share one channel, node i owns data item i + 1
+class SafScenarioTestCase : public TestCase {
+ public:
+  SafScenarioTestCase(std::string name);
+  virtual ~SafScenarioTestCase();
+
+ protected:
+  // connect the nodes so that every node hears every other one until their link is cut
+  void Build(uint32_t numNodes, Time delay);
+
+  // install the applications, unless the nodes look items up on their own only the lookups
+  // the test schedules are made
+  void Install(SafApplicationHelper& helper, bool scripted = true);
+
+  void Lookup(Time at, uint32_t node, uint16_t dataID);
+
+  // drop everything node a and b send each other from then on
+  void Cut(Time at, uint32_t a, uint32_t b);
+
+  void Run(Time stop);
+
+  // what the stats sink counted for the node
+  uint64_t GetCount(uint32_t node, SafStatsSink::Counter counter) const;
+
+  // called with the index of the node for every request it sends
+  virtual void Sent(std::string context, Ptr<const Packet> packet);
+
+  Ptr<SafCounterSink> m_stats;
+  std::vector<uint32_t> m_sent;  // node -> requests sent, forwarded ones included
+
+ private:
+
+  NodeContainer m_nodes;
+  NetDeviceContainer m_devices;
+  ApplicationContainer m_apps;
+};
+
+SafScenarioTestCase::SafScenarioTestCase(std::string name) : TestCase(name) {}
+
+SafScenarioTestCase::~SafScenarioTestCase() {}
+
+void SafScenarioTestCase::Build(uint32_t numNodes, Time delay) {
+  m_nodes = NodeContainer();
+  m_nodes.Create(numNodes);
+
+  SimpleNetDeviceHelper simple;
+  simple.SetChannelAttribute("Delay", TimeValue(delay));
+  m_devices = simple.Install(m_nodes);
+
+  InternetStackHelper internet;
+  internet.SetIpv6StackInstall(false);
+  internet.Install(m_nodes);
+  internet.AssignStreams(m_nodes, 0);
+
+  // the address generator outlives the simulation, every run starts from the same addresses
+  Ipv4AddressGenerator::Reset();
+  Ipv4AddressHelper ipv4("10.1.1.0", "255.255.255.0");
+  ipv4.Assign(m_devices);
+
+  m_stats = CreateObject<SafCounterSink>();
+  m_stats->Reserve(numNodes);
+  m_sent.assign(numNodes, 0);
+}
+
+void SafScenarioTestCase::Install(SafApplicationHelper& helper, bool scripted) {
+  helper.SetAttribute("accessFrequencyMode", UintegerValue(1));
+  helper.SetAttribute("StatsSink", PointerValue(m_stats));
+  m_apps = helper.Install(m_nodes);
+  helper.AssignStreams(m_nodes, 100);
+
+  // a mean of two months between lookups, so the nodes never look anything up on their own
+  Ptr<SafCatalog> catalog = CreateObject<SafCatalog>();
+  catalog->Init(m_nodes.GetN(), 1, 0.0, Seconds(1e7));
+
+  for (uint32_t i = 0; i < m_apps.GetN(); i++) {
+    if (scripted) {
+      m_apps.Get(i)->SetAttribute("Catalog", PointerValue(catalog));
+    }
+    m_apps.Get(i)->TraceConnect(
+        "Tx",
+        std::to_string(i),
+        MakeCallback(&SafScenarioTestCase::Sent, this));
+  }
+  m_apps.Start(Seconds(0));
+  m_apps.Stop(Seconds(60));
+}
+
+void SafScenarioTestCase::Lookup(Time at, uint32_t node, uint16_t dataID) {
+  Ptr<SafApplication> app = DynamicCast<SafApplication>(m_apps.Get(node));
+  Simulator::Schedule(at, &SafApplication::LookupData, app, dataID);
+}
+
+void SafScenarioTestCase::Cut(Time at, uint32_t a, uint32_t b) {
+  Ptr<SimpleNetDevice> first = DynamicCast<SimpleNetDevice>(m_devices.Get(a));
+  Ptr<SimpleNetDevice> second = DynamicCast<SimpleNetDevice>(m_devices.Get(b));
+  Ptr<SimpleChannel> channel = DynamicCast<SimpleChannel>(first->GetChannel());
+  Simulator::Schedule(at, &SimpleChannel::BlackList, channel, first, second);
+  Simulator::Schedule(at, &SimpleChannel::BlackList, channel, second, first);
+}
+
+void SafScenarioTestCase::Run(Time stop) {
+  Simulator::Stop(stop);
+  Simulator::Run();
+  Simulator::Destroy();
+}
+
+uint64_t SafScenarioTestCase::GetCount(uint32_t node, SafStatsSink::Counter counter) const {
+  return m_stats->GetCount(m_nodes.Get(node)->GetId(), counter);
+}
+
+void SafScenarioTestCase::Sent(std::string context, Ptr<const Packet> packet) {
+  m_sent[std::stoul(context)]++;
+}
+
+// Checks that lookups of an item that is already being looked up wait for the same answer
+class CoalescedLookupTestCase : public SafScenarioTestCase {
+ public:
+  CoalescedLookupTestCase();
+  virtual ~CoalescedLookupTestCase();
+
+ private:
+  virtual void DoRun(void);
+};
+
+CoalescedLookupTestCase::CoalescedLookupTestCase()
+    : SafScenarioTestCase("Concurrent lookups share one request") {}
+
+CoalescedLookupTestCase::~CoalescedLookupTestCase() {}
+
+void CoalescedLookupTestCase::DoRun(void) {
+  Build(2, MilliSeconds(10));
+  SafApplicationHelper helper(5000, 2, 2);
+  helper.SetAttribute("RequestTimeout", TimeValue(Seconds(1)));
+  Install(helper);
+
+  // the answer takes at least two channel delays, the later lookups are made before it
+  Lookup(MilliSeconds(1000), 1, 1);
+  Lookup(MilliSeconds(1001), 1, 1);
+  Lookup(MilliSeconds(1002), 1, 1);
+  Lookup(Seconds(3), 1, 1);
+  Run(Seconds(5));
+
+  NS_TEST_ASSERT_MSG_EQ(m_sent[1], 1, "one request should go on the wire");
+  NS_TEST_ASSERT_MSG_EQ(GetCount(1, SafStatsSink::LOOKUP_SENT), 1, "one lookup is sent");
+  NS_TEST_ASSERT_MSG_EQ(GetCount(1, SafStatsSink::LOOKUP_COALESCED), 2, "the others wait on it");
+  NS_TEST_ASSERT_MSG_EQ(GetCount(0, SafStatsSink::LOOKUP_RSP_SENT), 1, "one answer is sent");
+  NS_TEST_ASSERT_MSG_EQ(
+      m_stats->GetDelayCalculator(SafStatsSink::LOOKUP_ONTIME)->GetCount(),
+      1,
+      "the sent lookup should be answered");
+  NS_TEST_ASSERT_MSG_EQ(
+      m_stats->GetDelayCalculator(SafStatsSink::LOOKUP_COALESCED_ONTIME)->GetCount(),
+      2,
+      "every waiting lookup should be answered");
+  NS_TEST_ASSERT_MSG_EQ(m_stats->GetTotal(SafStatsSink::LOOKUP_TIMEOUT), 0, "nothing times out");
+  NS_TEST_ASSERT_MSG_EQ(GetCount(1, SafStatsSink::CACHE_HIT), 1, "the answer is kept");
+}
+
+// Checks that a bystander keeps an item from a response it overhears and serves it locally
+class OverheardResponseTestCase : public SafScenarioTestCase {
+ public:
+  OverheardResponseTestCase();
+  virtual ~OverheardResponseTestCase();
+
+ private:
+  virtual void DoRun(void);
+};
+
+OverheardResponseTestCase::OverheardResponseTestCase()
+    : SafScenarioTestCase("A bystander caches an overheard response") {}
+
+OverheardResponseTestCase::~OverheardResponseTestCase() {}
+
+void OverheardResponseTestCase::DoRun(void) {
+  Build(3, MilliSeconds(1));
+  SafApplicationHelper helper(5000, 3, 3);
+  helper.SetAttribute("BroadcastResponses", BooleanValue(true));
+  helper.SetAttribute("CacheOverheard", BooleanValue(true));
+  Install(helper);
+
+  // node 1 answers node 0, node 2 only hears it
+  Lookup(Seconds(1), 0, 2);
+  Lookup(Seconds(2), 2, 2);
+  Run(Seconds(3));
+
+  NS_TEST_ASSERT_MSG_EQ(GetCount(1, SafStatsSink::LOOKUP_RSP_SENT), 1, "the owner answers");
+  NS_TEST_ASSERT_MSG_EQ(
+      m_stats->GetDelayCalculator(SafStatsSink::LOOKUP_ONTIME)->GetCount(),
+      1,
+      "the requester should be answered");
+  NS_TEST_ASSERT_MSG_EQ(GetCount(2, SafStatsSink::OVERHEARD_RCV), 1, "the bystander hears it");
+  NS_TEST_ASSERT_MSG_EQ(GetCount(2, SafStatsSink::OVERHEARD_SAVED), 1, "and stores the item");
+  NS_TEST_ASSERT_MSG_EQ(GetCount(0, SafStatsSink::OVERHEARD_RCV), 0, "the answer was pending");
+
+  // the later lookup of the bystander never reaches the channel
+  NS_TEST_ASSERT_MSG_EQ(GetCount(2, SafStatsSink::CACHE_HIT), 1, "served from the store");
+  NS_TEST_ASSERT_MSG_EQ(GetCount(2, SafStatsSink::OVERHEARD_HIT), 1, "the overheard item is used");
+  NS_TEST_ASSERT_MSG_EQ(GetCount(2, SafStatsSink::LOOKUP_SENT), 0, "nothing is asked for");
+  NS_TEST_ASSERT_MSG_EQ(m_sent[2], 0, "the bystander sends no request");
+}
+
+// Checks that of two holders of an item only one answers and the other cancels its response
+class SuppressedResponseTestCase : public SafScenarioTestCase {
+ public:
+  SuppressedResponseTestCase();
+  virtual ~SuppressedResponseTestCase();
+
+ private:
+  virtual void DoRun(void);
+};
+
+SuppressedResponseTestCase::SuppressedResponseTestCase()
+    : SafScenarioTestCase("Response suppression between two holders") {}
+
+SuppressedResponseTestCase::~SuppressedResponseTestCase() {}
+
+void SuppressedResponseTestCase::DoRun(void) {
+  // without a channel delay a response is heard as soon as it is sent, so the holder that
+  // backs off longer always hears the other one first
+  Build(3, Seconds(0));
+  SafApplicationHelper helper(5000, 3, 3);
+  helper.SetAttribute("StorageSpace", UintegerValue(1));
+  helper.SetAttribute("ReallocationPeriod", TimeValue(Seconds(1)));
+  helper.SetAttribute("RequestTimeout", TimeValue(Seconds(1)));
+  helper.SetAttribute("ResponseSuppression", BooleanValue(true));
+  Install(helper);
+
+  // item 3 is the most frequently accessed, then item 2, so after the reallocation at 1s
+  // nodes 0 and 1 hold a replica of item 3 and node 2 one of item 2, the item node 1 owns
+  Lookup(MilliSeconds(1500), 0, 2);
+  Run(Seconds(3));
+
+  NS_TEST_ASSERT_MSG_EQ(
+      m_stats->GetTotal(SafStatsSink::REALLOC_RSP_SENT),
+      3,
+      "every node should get its replica");
+
+  uint64_t sent1 = GetCount(1, SafStatsSink::LOOKUP_RSP_SENT);
+  uint64_t sent2 = GetCount(2, SafStatsSink::LOOKUP_RSP_SENT);
+  uint64_t suppressed1 = GetCount(1, SafStatsSink::RSP_SUPPRESSED);
+  uint64_t suppressed2 = GetCount(2, SafStatsSink::RSP_SUPPRESSED);
+  NS_TEST_ASSERT_MSG_EQ(GetCount(1, SafStatsSink::LOOKUP_RCV), 1, "the owner gets the lookup");
+  NS_TEST_ASSERT_MSG_EQ(GetCount(2, SafStatsSink::LOOKUP_RCV), 1, "so does the other holder");
+  NS_TEST_ASSERT_MSG_EQ(sent1 + sent2, 1, "only one holder should answer");
+  NS_TEST_ASSERT_MSG_EQ(suppressed1 + suppressed2, 1, "the other should cancel its response");
+  NS_TEST_ASSERT_MSG_EQ(suppressed1, sent2, "the holder that did not answer cancels");
+  NS_TEST_ASSERT_MSG_EQ(
+      m_stats->GetDelayCalculator(SafStatsSink::LOOKUP_ONTIME)->GetCount(),
+      1,
+      "the requester should be answered");
+  NS_TEST_ASSERT_MSG_EQ(m_stats->GetTotal(SafStatsSink::LOOKUP_TIMEOUT), 0, "nothing times out");
+}
+
+// Checks that a lookup sent to a holder that is out of reach falls back to a broadcast, which
+// reaches the holder over a relay and is answered the same way back
+class UnicastFallbackTestCase : public SafScenarioTestCase {
+ public:
+  UnicastFallbackTestCase();
+  virtual ~UnicastFallbackTestCase();
+
+ private:
+  virtual void DoRun(void);
+};
+
+UnicastFallbackTestCase::UnicastFallbackTestCase()
+    : SafScenarioTestCase("Unicast lookup falls back to a relayed broadcast") {}
+
+UnicastFallbackTestCase::~UnicastFallbackTestCase() {}
+
+void UnicastFallbackTestCase::DoRun(void) {
+  Build(3, MilliSeconds(1));
+  SafApplicationHelper helper(5000, 3, 3);
+  helper.SetAttribute("StorageSpace", UintegerValue(0));  // every lookup has to be sent
+  helper.SetAttribute("LocationCacheSize", UintegerValue(3));
+  helper.SetAttribute("MaxHops", UintegerValue(2));
+  helper.SetAttribute("RequestTimeout", TimeValue(Seconds(2)));
+  Install(helper);
+
+  // node 0 learns that node 2 holds item 3, then only reaches it through node 1
+  Lookup(Seconds(1), 0, 3);
+  Cut(Seconds(2), 0, 2);
+
+  // the unicast times out at 5s, the first ring at 6s, the second ring is relayed by node 1
+  Lookup(Seconds(3), 0, 3);
+  Run(Seconds(10));
+
+  NS_TEST_ASSERT_MSG_EQ(GetCount(0, SafStatsSink::LOOKUP_SENT), 2, "two lookups are made");
+  NS_TEST_ASSERT_MSG_EQ(m_sent[0], 4, "a broadcast, the unicast and two rings are sent");
+  NS_TEST_ASSERT_MSG_EQ(GetCount(1, SafStatsSink::REQUEST_FORWARDED), 1, "the relay forwards");
+  NS_TEST_ASSERT_MSG_EQ(m_sent[1], 1, "only the second ring is forwarded");
+  NS_TEST_ASSERT_MSG_EQ(GetCount(2, SafStatsSink::LOOKUP_RCV), 2, "the unicast never arrives");
+  NS_TEST_ASSERT_MSG_EQ(GetCount(2, SafStatsSink::LOOKUP_RSP_SENT), 2, "the holder answers both");
+
+  // node 0 can not hear node 2 any more, so the answer came back through node 1
+  Ptr<TimeHistogramCalculator> ontime = m_stats->GetDelayCalculator(SafStatsSink::LOOKUP_ONTIME);
+  NS_TEST_ASSERT_MSG_EQ(ontime->GetCount(), 2, "both lookups should be answered");
+  NS_TEST_ASSERT_MSG_GT(ontime->GetTotal(), Seconds(3), "the fallback waits out the timeouts");
+  NS_TEST_ASSERT_MSG_EQ(m_stats->GetTotal(SafStatsSink::LOOKUP_TIMEOUT), 0, "nothing times out");
+}
+
+// Checks that a simulation run after another one in the same process behaves the same way
+class RepeatedSimulationTestCase : public SafScenarioTestCase {
+ public:
+  RepeatedSimulationTestCase();
+  virtual ~RepeatedSimulationTestCase();
+
+ private:
+  virtual void DoRun(void);
+  virtual void Sent(std::string context, Ptr<const Packet> packet);
+
+  // run a simulation in which the nodes look items up on their own
+  void RunOnce(void);
+
+  SafCodec m_codec;
+  std::vector<uint32_t> m_ids;     // IDs of the requests in the order they were sent
+  std::vector<uint64_t> m_counts;  // node * NUM_COUNTERS + counter -> count
+  std::vector<uint64_t> m_delays;  // number of delays recorded of each kind
+  std::vector<Time> m_totals;      // sum of the delays recorded of each kind
+};
+
+RepeatedSimulationTestCase::RepeatedSimulationTestCase()
+    : SafScenarioTestCase("Repeated simulations in one process") {
+  m_codec.SetWireFormat(SafCodec::GetDefaultWireFormat());
+}
+
+RepeatedSimulationTestCase::~RepeatedSimulationTestCase() {}
+
+void RepeatedSimulationTestCase::Sent(std::string context, Ptr<const Packet> packet) {
+  SafScenarioTestCase::Sent(context, packet);
+
+  SafHeader header;
+  if (m_codec.Decode(packet, header)) {
+    m_ids.push_back(header.GetId());
+  }
+}
+
+void RepeatedSimulationTestCase::RunOnce(void) {
+  Build(3, MilliSeconds(1));
+  SafApplicationHelper helper(5000, 3, 3);
+  helper.SetAttribute("StorageSpace", UintegerValue(1));  // most lookups have to be sent
+  helper.SetAttribute("ReallocationPeriod", TimeValue(Seconds(4)));
+  helper.SetAttribute("RequestTimeout", TimeValue(Seconds(1)));
+  Install(helper, false);
+
+  m_ids.clear();
+  Run(Seconds(20));
+
+  m_counts.clear();
+  for (uint32_t node = 0; node < 3; node++) {
+    for (int counter = 0; counter < SafStatsSink::NUM_COUNTERS; counter++) {
+      m_counts.push_back(GetCount(node, static_cast<SafStatsSink::Counter>(counter)));
+    }
+  }
+
+  m_delays.clear();
+  m_totals.clear();
+  for (int delay = 0; delay < SafStatsSink::NUM_DELAYS; delay++) {
+    Ptr<TimeHistogramCalculator> calculator =
+        m_stats->GetDelayCalculator(static_cast<SafStatsSink::Delay>(delay));
+    m_delays.push_back(calculator->GetCount());
+    m_totals.push_back(calculator->GetTotal());
+  }
+}
+
+void RepeatedSimulationTestCase::DoRun(void) {
+  RunOnce();
+  std::vector<uint32_t> ids = m_ids;
+  std::vector<uint64_t> counts = m_counts;
+  std::vector<uint64_t> delays = m_delays;
+  std::vector<Time> totals = m_totals;
+
+  // nothing is left over from the first simulation to change the course of the second
+  RunOnce();
+
+  NS_TEST_ASSERT_MSG_GT(m_stats->GetTotal(SafStatsSink::LOOKUP_SENT), 0, "lookups should be sent");
+  NS_TEST_ASSERT_MSG_GT(m_ids.size(), 0, "requests should go on the wire");
+  NS_TEST_ASSERT_MSG_EQ(m_ids.size(), ids.size(), "both should send as many requests");
+  NS_TEST_ASSERT_MSG_EQ((m_ids == ids), true, "the message IDs should restart");
+  NS_TEST_ASSERT_MSG_EQ((m_counts == counts), true, "every node should count the same");
+  NS_TEST_ASSERT_MSG_EQ((m_delays == delays), true, "as many delays should be recorded");
+  NS_TEST_ASSERT_MSG_EQ((m_totals == totals), true, "the delays should be the same");
+}
+
+// Compares the CPU time and packet size of each wire format
+class SafCodecBenchmarkTestCase : public TestCase {
+ public:
+  SafCodecBenchmarkTestCase();
+  virtual ~SafCodecBenchmarkTestCase();
+
+ private:
+  virtual void DoRun(void);
+};
+
+SafCodecBenchmarkTestCase::SafCodecBenchmarkTestCase()
+    : TestCase("Wire format encode and decode cost") {}
+
+SafCodecBenchmarkTestCase::~SafCodecBenchmarkTestCase() {}
+
+void SafCodecBenchmarkTestCase::DoRun(void) {
+  const uint32_t iterations = 100000;
+  const uint32_t dataSize = 1024;
+
+  SafCodec::WireFormat formats[] = {SafCodec::PROTOBUF, SafCodec::HEADER};
+  const char* names[] = {"protobuf", "header"};
+
+  for (uint32_t f = 0; f < 2; f++) {
+    if (!SafCodec::IsSupported(formats[f])) {
+      continue;
+    }
+
+    SafCodec codec;
+    codec.SetWireFormat(formats[f]);
+    codec.Reserve(dataSize);
+
+    for (bool response : {false, true}) {
+      SafHeader sent = MakeMessage(response, dataSize);
+      SafHeader recvd;
+      uint32_t bytes = 0;
+
+      auto start = std::chrono::steady_clock::now();
+      for (uint32_t i = 0; i < iterations; i++) {
+        sent.SetId(i);
+        Ptr<Packet> packet = codec.Encode(sent);
+        codec.Decode(packet, recvd);
+        bytes = packet->GetSize();
+      }
+      auto end = std::chrono::steady_clock::now();
+
+      double ns = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+      std::cout << names[f] << " " << (response ? "response" : "request") << ": " << bytes
+                << " bytes on air, " << ns << " ns per encode and decode" << std::endl;
+
+      NS_TEST_ASSERT_MSG_EQ(recvd.GetId(), iterations - 1, "last message should decode");
+    }
+  }
+}
+
 // The TestSuite class names the TestSuite, identifies what type of TestSuite,
 // and enables the TestCases to be run.  Typically, only the constructor for
 // this class must be defined
@@ -50,6 +1465,29 @@ class SafTestSuite : public TestSuite {
 SafTestSuite::SafTestSuite() : TestSuite("saf", UNIT) {
   // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
   AddTestCase(new SafTestCase1, TestCase::QUICK);
+  AddTestCase(new DataStoreTestCase, TestCase::QUICK);
+  AddTestCase(new DataIdSetTestCase, TestCase::QUICK);
+  AddTestCase(new ReplicaHeapTestCase, TestCase::QUICK);
+  AddTestCase(new LocationCacheTestCase, TestCase::QUICK);
+  AddTestCase(new SeenRequestCacheTestCase, TestCase::QUICK);
+  AddTestCase(new TimeHistogramCalculatorTestCase, TestCase::QUICK);
+  AddTestCase(new SafCounterSinkTestCase, TestCase::QUICK);
+  AddTestCase(new MessageIdGeneratorTestCase, TestCase::QUICK);
+  AddTestCase(new SafStatsSamplerTestCase, TestCase::QUICK);
+  AddTestCase(new ItemCounterMatrixTestCase, TestCase::QUICK);
+  AddTestCase(new SafCatalogTestCase, TestCase::QUICK);
+  AddTestCase(new ReplicaAllocationPolicyTestCase, TestCase::QUICK);
+  AddTestCase(new LookupSamplerTestCase, TestCase::QUICK);
+  AddTestCase(new DeadlineQueueTestCase, TestCase::QUICK);
+  AddTestCase(new PendingRequestTableTestCase, TestCase::QUICK);
+  AddTestCase(new SafHeaderTestCase, TestCase::QUICK);
+  AddTestCase(new SafCodecTestCase, TestCase::QUICK);
+  AddTestCase(new CoalescedLookupTestCase, TestCase::QUICK);
+  AddTestCase(new OverheardResponseTestCase, TestCase::QUICK);
+  AddTestCase(new SuppressedResponseTestCase, TestCase::QUICK);
+  AddTestCase(new UnicastFallbackTestCase, TestCase::QUICK);
+  AddTestCase(new RepeatedSimulationTestCase, TestCase::QUICK);
+  AddTestCase(new SafCodecBenchmarkTestCase, TestCase::EXTENSIVE);
 }
 
 // Do not forget to allocate an instance of this TestSuite